@@ -2,15 +2,49 @@
 #define SCHEDULER_CONFIG_H
 
 //#define SCHEDULER_CUSTOM_TIMER        // Indicates custom hardware timer settings should be used
-//#define TMR_REG               TMR5    // Hardware timer, must be a 16 bit timer
+//#define TMR_REG               TMR5    // Hardware timer, must be a 16 or 32 bit timer
+//#define TMR_PR_REG            PR5     // Hardware timer period register
 //#define TMR_CFG_REG           T5CON   // Hardware timer register
-//#define TMR_CFG_WORD          0xA040  // Hardware timer configuration word
+//#define TMR_CFG_WORD          0x8040  // Hardware timer configuration word, must keep running in idle mode for tickless idle
 //#define TMR_PRESCALER         16      // Hardware timer prescaler
 //#define TMR_CFG_EN_BIT        15      // Hardware timer enable bit of the configuration word
+//#define TMR_BITS              16      // Hardware timer width, either 16 or 32
 
 //#define PBCLK_FREQUENCY       80000000LU  // Frequency of the peripheral bus, only needed when _SYS_CLK and _PB_DIV are not defined
+//#define SYSCLK_FREQUENCY      80000000LU  // Frequency of the system clock, only needed for tickless idle or the dispatch budget when _SYS_CLK is not defined
+
+//#define SCHEDULER_DISPATCH_BUDGET_US  250 // Execute all ready events per pass until this many microseconds are spent, comment to execute a single event per pass
+
+//#define SCHEDULER_LOAD_METER              // Split core time into events, deferred work, robin tasks, interrupts, idle and overhead, see scheduler_load()
+#define SCHEDULER_LOAD_SAMPLE_MS    10      // Sample period of the load meter, must divide the shortest averaging window of 100 ms
+//#define SCHEDULER_LOAD_REPORT_S   1       // Interval of the load report printed by main, requires SCHEDULER_LOAD_METER
+
+//#define SCHEDULER_PROFILING               // Record call count, execution cycles and lateness per event and robin task, see scheduler_print_profile()
+
+//#define SCHEDULER_TICKLESS_IDLE           // Enter idle mode until the next deadline when there is nothing to execute, disabled while robin tasks exist
+#define SCHEDULER_IDLE_MIN_US   20          // Shorter idle periods are not worth the wake-up latency
+#define SCHEDULER_IDLE_MAX_US   500000      // Longest idle period, must stay well within the watchdog period
+
+#define SCHEDULER_POLICY        SCHEDULER_POLICY_PRIORITY   // Either SCHEDULER_POLICY_PRIORITY, SCHEDULER_POLICY_EDF or SCHEDULER_POLICY_RM
+
+// Worst case event set, checked at compile-time against the utilization bound of the policy. Entries are X(name, interval in us, worst case execution time in us)
+//#define SCHEDULER_EVENT_SET(X)  X(timer, 500, 20) X(refresh, 1000, 300)
+
+//#define SCHEDULER_PHASE_SPREADING         // Events created without a phase get the phase that collides least with the existing events
+#define SCHEDULER_PHASE_CANDIDATES  16      // Number of evenly spaced phases within the interval that are considered
+
+//#define SCHEDULER_CYCLIC_EXECUTIVE        // Execute the static event table at every minor frame, before any dynamic event
+#define SCHEDULER_MINOR_FRAME_US    500     // Length of a minor frame
+#define SCHEDULER_MAJOR_FRAME       20      // Length of the major frame in minor frames, every static event period must divide it
+
+// Static event table, executed in the listed order. Entries are X(handle, period in minor frames, offset in minor frames)
+// TIMER_STATIC_EVENTS holds 'timer_execute' unless the timer is advanced by its hardware tick, see timer.h
+#define SCHEDULER_STATIC_EVENTS(X)  TIMER_STATIC_EVENTS(X)
+
+//#define SCHEDULER_ROBIN_QUANTUM_US  100  // Core time per unit of weight a robin task receives each round, comment for plain round-robin
 
 #define EVENT_POOL_SIZE         5
 #define ROBIN_TASK_POOL_SIZE    5
+#define SCHEDULER_POST_QUEUE_SIZE   8   // Deferred work slots per interrupt priority level, must be a power of two
 
 #endif /* SCHEDULER_CONFIG_H */
\ No newline at end of file
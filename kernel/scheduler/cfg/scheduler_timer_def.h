@@ -11,11 +11,13 @@
         (__PIC32_FEATURE_SET__ == 450)  ||  \
         (__PIC32_FEATURE_SET__ == 470)
 
-            #define _TMR_REG                TMR5
-            #define _TMR_CFG_REG            T5CON
-            #define _TMR_CFG_WORD           0xA040 // Timer on; Discontinue in idle mode; 1:16 prescaler
+            #define _TMR_REG                TMR4 // TMR4 and TMR5 cascaded into a single 32 bit timer
+            #define _TMR_PR_REG             PR4
+            #define _TMR_CFG_REG            T4CON
+            #define _TMR_CFG_WORD           0x8048 // Timer on; Continue in idle mode; 1:16 prescaler; 32 bit mode
             #define _TMR_PRESCALER          16
             #define _TMR_CFG_EN_BIT         15
+            #define _TMR_BITS               32
             #undef SCHEDULER_NO_HW_TIMER
     #endif
 #endif
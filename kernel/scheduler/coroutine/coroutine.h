@@ -0,0 +1,89 @@
+#ifndef COROUTINE_H
+#define COROUTINE_H
+
+#include "../../utils/timer/timer.h"
+
+/*
+ * Stackless coroutines for robin tasks, allowing a long job to be sliced across scheduler passes.
+ * The resume point is kept in a 'struct Coroutine', execution continues from the last yield on the next call.
+ *
+ * void render_task()
+ * {
+ *     static struct Coroutine co = COROUTINE_INITIALIZER;
+ *     static unsigned char layer;
+ *
+ *     COROUTINE_BEGIN(&co);
+ *     for(layer = 0; layer < 16; ++layer) {
+ *         render_layer(layer);
+ *         COROUTINE_YIELD(&co);
+ *     }
+ *     COROUTINE_SLEEP(&co, frameTimer, 40, TIMER_UNIT_MS);
+ *     COROUTINE_END(&co);
+ * }
+ *
+ * Local variables are not preserved across a yield, use static variables instead.
+ * A 'switch' statement must not enclose a yield, since the coroutine itself is implemented as one.
+ * The handle must return void, robin task handles therefore qualify directly.
+ */
+
+#define COROUTINE_INITIALIZER   { 0 }
+
+struct Coroutine
+{
+    unsigned short line; // Resume point, '0' when the coroutine (re)starts from the beginning
+};
+
+/**
+ * Resets a coroutine, it starts from the beginning on the next call
+ * @param co The coroutine to be reset
+ */
+#define COROUTINE_RESET(co)                     ((co)->line = 0)
+
+/**
+ * Marks the start of the coroutine body
+ * @param co The coroutine state
+ */
+#define COROUTINE_BEGIN(co)                     switch((co)->line) { case 0:
+
+/**
+ * Marks the end of the coroutine body, the coroutine starts from the beginning on the next call
+ * @param co The coroutine state
+ */
+#define COROUTINE_END(co)                       } (co)->line = 0; return
+
+/**
+ * Returns to the scheduler, the coroutine resumes after this statement on the next call
+ * @param co The coroutine state
+ */
+#define COROUTINE_YIELD(co)                     do { (co)->line = __LINE__; return; case __LINE__:; } while(0)
+
+/**
+ * Returns to the scheduler until a condition holds, the condition is re-evaluated on every call
+ * @param co The coroutine state
+ * @param condition The condition to wait for
+ */
+#define COROUTINE_WAIT_UNTIL(co, condition)     do { (co)->line = __LINE__; case __LINE__: if(!(condition)) return; } while(0)
+
+/**
+ * Returns to the scheduler until a timer has timed out
+ * @param co The coroutine state
+ * @param timer The timer to wait for, should be a started countdown timer
+ */
+#define COROUTINE_WAIT_TIMER(co, timer)         COROUTINE_WAIT_UNTIL(co, timer_timed_out(timer))
+
+/**
+ * Starts a timer and returns to the scheduler until it has timed out
+ * @param co The coroutine state
+ * @param timer The countdown timer to use
+ * @param time The time to sleep
+ * @param unit The time unit
+ */
+#define COROUTINE_SLEEP(co, timer, time, unit)  do { timer_start(timer, time, unit); COROUTINE_WAIT_TIMER(co, timer); } while(0)
+
+/**
+ * Ends the coroutine early, it starts from the beginning on the next call
+ * @param co The coroutine state
+ */
+#define COROUTINE_EXIT(co)                      do { (co)->line = 0; return; } while(0)
+
+#endif /* COROUTINE_H */
\ No newline at end of file
@@ -1,65 +1,375 @@
 #include "scheduler.h"
 #include "cfg/scheduler_config.h"
 #include "cfg/scheduler_timer_def.h"
+#include "../utils/timer/timer.h"
+#include "../../peripheral/interrupt/interrupt.h"
+#include "../../lib/print/print.h"
 #include <xc.h>
 #include <stddef.h>
+#include <limits.h>
 
 #define EVENT_DEF_POOL_SIZE         5
-#define EVENT_MAX_POOL_SIZE         50
+#define EVENT_MAX_POOL_SIZE         500
 #define ROBIN_TASK_DEF_POOL_SIZE    5
 #define ROBIN_TASK_MAX_POOL_SIZE    50
+#define EVENT_PRIO_COUNT            (PRIO_LOW + 1)
+#define POST_QUEUE_DEF_SIZE         8
+#define PHASE_DEF_CANDIDATES        16
+#define LOAD_FRACTION_BITS          16 // Fixed point fraction of the averaged load
+#define POST_IPL_COUNT              8 // One post queue for each interrupt priority level, including the main loop
+#define cp0StatusIpl(status)        (((status) >> 10) & 0x07)
+
+// Identifiers hold the pool index in the lower half and the generation of the slot in the upper half
+#define makeId(generation, index)   (((SchedulerId)(generation) << 16) | (SchedulerId)(index))
+#define idIndex(id)                 ((size_t)((id) & 0xFFFF))
+#define idGeneration(id)            ((unsigned short)((id) >> 16))
+#define nextGeneration(generation)  (((unsigned short)((generation) + 1) != 0) ? (unsigned short)((generation) + 1) : 1) // Generation zero is reserved for the invalid identifier
+
+#define isDue(deadline, now)        ((deadline) <= (now)) // 64 bit system ticks never wrap
+#define isBefore(first, second)     ((first) < (second))
 
 #ifdef SCHEDULER_CUSTOM_TIMER
     #define HW_TIMER            TMR_REG
+    #define HW_TIMER_PR_REG     TMR_PR_REG
     #define HW_TIMER_CFG_REG    TMR_CFG_REG
     #define HW_TIMER_CFG_WORD   TMR_CFG_WORD
     #define HW_TIMER_PRESCALER  TMR_PRESCALER
     #define HW_TIMER_CFG_EN_BIT TMR_CFG_EN_BIT
+    #define HW_TIMER_BITS       TMR_BITS
 #elif !defined(SCHEDULER_NO_HW_TIMER)
     #define HW_TIMER            _TMR_REG
+    #define HW_TIMER_PR_REG     _TMR_PR_REG
     #define HW_TIMER_CFG_REG    _TMR_CFG_REG
     #define HW_TIMER_CFG_WORD   _TMR_CFG_WORD
     #define HW_TIMER_PRESCALER  _TMR_PRESCALER
     #define HW_TIMER_CFG_EN_BIT _TMR_CFG_EN_BIT
+    #define HW_TIMER_BITS       _TMR_BITS
 #else
     #error "No valid hardware timer configuration found."
 #endif
 
+#if (HW_TIMER_BITS == 32)
+    #define HW_TIMER_MASK       0xFFFFFFFFLU
+#elif (HW_TIMER_BITS == 16)
+    #define HW_TIMER_MASK       0x0000FFFFLU
+#else
+    #error "Hardware timer must be either a 16 or 32 bit timer."
+#endif
+
 #if defined(_SYS_CLK) && defined(_PB_DIV)
-    #define SYSTEM_TICK ((1000000.0F / (_SYS_CLK / _PB_DIV)) * HW_TIMER_PRESCALER)
+    #define SYSTEM_TICK_FREQUENCY ((_SYS_CLK / _PB_DIV) / HW_TIMER_PRESCALER)
 #elif defined(PBCLK_FREQUENCY)
-    #define SYSTEM_TICK ((1000000.0F / PBCLK_FREQUENCY) * HW_TIMER_PRESCALER)
+    #define SYSTEM_TICK_FREQUENCY (PBCLK_FREQUENCY / HW_TIMER_PRESCALER)
 #else
     #error "System tick could not be calculated, please define the PBCLK_FREQUENCY in scheduler_config.h or _SYS_CLK and _PB_DIV globally."
 #endif
 
-static unsigned long calc_sys_ticks(unsigned short time, enum SchedulerIntervalUnit unit);
-static void sort_events();
-static struct Event* find_event(unsigned int identifier);
-static void sort_robin_tasks();
-static struct RobinTask* find_robin_task(unsigned int identifier);
+#ifndef SCHEDULER_POLICY
+    #define SCHEDULER_POLICY            SCHEDULER_POLICY_PRIORITY
+#endif
+
+#if (SCHEDULER_POLICY == SCHEDULER_POLICY_PRIORITY)
+    #define READY_LIST_COUNT            EVENT_PRIO_COUNT // A FIFO for each priority
+    #define readyList(event)            ((event)->opt.priority)
+#elif (SCHEDULER_POLICY == SCHEDULER_POLICY_EDF)
+    #define READY_LIST_COUNT            1 // A single list ordered on the absolute deadline
+    #define readyList(event)            0
+    #define readyKey(event)             ((event)->release + (event)->deadline)
+#elif (SCHEDULER_POLICY == SCHEDULER_POLICY_RM)
+    #define READY_LIST_COUNT            1 // A single list ordered on the interval, shortest interval first
+    #define readyList(event)            0
+    #define readyKey(event)             ((event)->interval)
+#else
+    #error "Unknown scheduling policy, use either SCHEDULER_POLICY_PRIORITY, SCHEDULER_POLICY_EDF or SCHEDULER_POLICY_RM."
+#endif
+
+// Compile-time schedulability check of the worst case event set, utilizations are in parts per million
+#ifdef SCHEDULER_EVENT_SET
+    #define eventUtilization(name, interval, wcet)  + (((wcet) * 1000000LU + (interval) - 1) / (interval))
+    #define eventCount(name, interval, wcet)        + 1
+    #define EVENT_SET_UTILIZATION                   (0 SCHEDULER_EVENT_SET(eventUtilization))
+    #define EVENT_SET_COUNT                         (0 SCHEDULER_EVENT_SET(eventCount))
+
+    #if (SCHEDULER_POLICY == SCHEDULER_POLICY_RM)
+        // Liu and Layland bound n * (2^(1/n) - 1), converging to ln(2) for larger sets
+        #if (EVENT_SET_COUNT <= 1)
+            #define EVENT_SET_BOUND     1000000LU
+        #elif (EVENT_SET_COUNT == 2)
+            #define EVENT_SET_BOUND     828427LU
+        #elif (EVENT_SET_COUNT == 3)
+            #define EVENT_SET_BOUND     779763LU
+        #elif (EVENT_SET_COUNT == 4)
+            #define EVENT_SET_BOUND     756828LU
+        #elif (EVENT_SET_COUNT == 5)
+            #define EVENT_SET_BOUND     743491LU
+        #elif (EVENT_SET_COUNT == 6)
+            #define EVENT_SET_BOUND     734772LU
+        #elif (EVENT_SET_COUNT == 7)
+            #define EVENT_SET_BOUND     728626LU
+        #elif (EVENT_SET_COUNT == 8)
+            #define EVENT_SET_BOUND     724061LU
+        #elif (EVENT_SET_COUNT == 9)
+            #define EVENT_SET_BOUND     720537LU
+        #else
+            #define EVENT_SET_BOUND     693147LU
+        #endif
+    #else
+        #define EVENT_SET_BOUND         1000000LU // Exact for EDF with deadlines equal to the interval, a necessary condition otherwise
+    #endif
+
+    #if (EVENT_SET_UTILIZATION > EVENT_SET_BOUND)
+        #error "Event set is not schedulable, the total utilization exceeds the bound of the scheduling policy."
+    #endif
+#endif
+
+// Static events are generated from the table in scheduler_config.h, entries are X(handle, period in minor frames, offset in minor frames)
+#ifdef SCHEDULER_CYCLIC_EXECUTIVE
+    #define staticEventPrototype(handle, period, offset)    void handle();
+    #define staticEventEntry(handle, period, offset)        { handle, period, offset },
+    #define staticEventInvalid(handle, period, offset)      + (((period) < 1) || ((SCHEDULER_MAJOR_FRAME % (period)) != 0) || ((offset) >= (period)))
+
+    #if !defined(SCHEDULER_MINOR_FRAME_US) || !defined(SCHEDULER_MAJOR_FRAME) || !defined(SCHEDULER_STATIC_EVENTS)
+        #error "The cyclic executive requires SCHEDULER_MINOR_FRAME_US, SCHEDULER_MAJOR_FRAME and SCHEDULER_STATIC_EVENTS to be defined."
+    #elif (SCHEDULER_MINOR_FRAME_US < 1) || (SCHEDULER_MAJOR_FRAME < 1)
+        #error "Minor frame and major frame must be non negative integers with a minimum of 1"
+    #elif ((0 SCHEDULER_STATIC_EVENTS(staticEventInvalid)) != 0)
+        #error "Every static event period must divide the major frame, and its offset must be smaller than its period."
+    #endif
+
+    #define MINOR_FRAME_TICKS           (((SchedulerTicks)SCHEDULER_MINOR_FRAME_US * SYSTEM_TICK_FREQUENCY) / 1000000LU)
+#endif
+
+#ifdef SCHEDULER_POST_QUEUE_SIZE
+    #if (SCHEDULER_POST_QUEUE_SIZE < 1) || ((SCHEDULER_POST_QUEUE_SIZE & (SCHEDULER_POST_QUEUE_SIZE - 1)) != 0)
+        #error "Post queue size must be a power of two with a minimum of 1"
+    #else
+        #define POST_QUEUE_SIZE SCHEDULER_POST_QUEUE_SIZE
+    #endif
+#else
+    #define POST_QUEUE_SIZE POST_QUEUE_DEF_SIZE
+#endif
+
+#ifdef SCHEDULER_PHASE_SPREADING
+    #define DEFAULT_PHASE               SCHEDULER_PHASE_AUTO
+#else
+    #define DEFAULT_PHASE               0
+#endif
+
+#ifdef SCHEDULER_PHASE_CANDIDATES
+    #if (SCHEDULER_PHASE_CANDIDATES < 1)
+        #error "Phase candidates must be a non negative integer with a minimum of 1"
+    #else
+        #define PHASE_CANDIDATES SCHEDULER_PHASE_CANDIDATES
+    #endif
+#else
+    #define PHASE_CANDIDATES PHASE_DEF_CANDIDATES
+#endif
+
+#if defined(SCHEDULER_TICKLESS_IDLE) || defined(SCHEDULER_DISPATCH_BUDGET_US) || defined(SCHEDULER_LOAD_METER) || defined(SCHEDULER_ROBIN_QUANTUM_US)
+    #if defined(_SYS_CLK)
+        #define CORE_TICK_FREQUENCY (_SYS_CLK / 2) // Core timer increments every other system clock
+    #elif defined(SYSCLK_FREQUENCY)
+        #define CORE_TICK_FREQUENCY (SYSCLK_FREQUENCY / 2)
+    #else
+        #error "Core tick could not be calculated, please define the SYSCLK_FREQUENCY in scheduler_config.h or _SYS_CLK globally."
+    #endif
+#endif
+
+#ifdef SCHEDULER_DISPATCH_BUDGET_US
+    #if (SCHEDULER_DISPATCH_BUDGET_US < 1)
+        #error "Dispatch budget must be a non negative integer with a minimum of 1"
+    #endif
+
+    #define DISPATCH_BUDGET_CYCLES      ((unsigned long)(((unsigned long long)SCHEDULER_DISPATCH_BUDGET_US * CORE_TICK_FREQUENCY) / 1000000LU))
+#endif
+
+#ifdef SCHEDULER_PROFILING
+    #define profileLateness(event)          profile_lateness(event)
+    #define profiledCall(profile, call)     do { const unsigned long _start = _CP0_GET_COUNT(); call; profile_record(profile, _CP0_GET_COUNT() - _start); } while(0)
+#else
+    #define profileLateness(event)
+    #define profiledCall(profile, call)     call
+#endif
+
+#ifdef SCHEDULER_ROBIN_QUANTUM_US
+    #if (SCHEDULER_ROBIN_QUANTUM_US < 1)
+        #error "Robin quantum must be a non negative integer with a minimum of 1"
+    #endif
+
+    #define ROBIN_QUANTUM_CYCLES        ((long)(((unsigned long long)SCHEDULER_ROBIN_QUANTUM_US * CORE_TICK_FREQUENCY) / 1000000LU))
+    #define ROBIN_MAX_DEMOTION          3
+    #define robinQuantum(task)          ((ROBIN_QUANTUM_CYCLES * (long)(task)->weight) >> (task)->opt.demotion)
+#endif
+
+#ifdef SCHEDULER_LOAD_METER
+    #if !defined(SCHEDULER_LOAD_SAMPLE_MS) || (SCHEDULER_LOAD_SAMPLE_MS < 1) || ((100 % SCHEDULER_LOAD_SAMPLE_MS) != 0)
+        #error "Load sample period must be defined and divide the 100 ms averaging window"
+    #endif
+
+    #define LOAD_SAMPLE_CYCLES          ((unsigned long)(((unsigned long long)SCHEDULER_LOAD_SAMPLE_MS * CORE_TICK_FREQUENCY) / 1000LU))
+    #define loadCharge(load)            load_charge(load)
+    #define meteredCall(load, call)     do { load_charge(SCHEDULER_LOAD_OVERHEAD); call; load_charge(load); } while(0)
+#else
+    #define loadCharge(load)
+    #define meteredCall(load, call)     call
+#endif
+
+#ifdef SCHEDULER_TICKLESS_IDLE
+    #if !defined(SCHEDULER_IDLE_MIN_US) || !defined(SCHEDULER_IDLE_MAX_US)
+        #error "Tickless idle requires both SCHEDULER_IDLE_MIN_US and SCHEDULER_IDLE_MAX_US to be defined."
+    #elif (SCHEDULER_IDLE_MIN_US >= SCHEDULER_IDLE_MAX_US)
+        #error "Minimum idle period must be shorter than the maximum idle period."
+    #endif
+
+    #define IDLE_MIN_TICKS              (((SchedulerTicks)SCHEDULER_IDLE_MIN_US * SYSTEM_TICK_FREQUENCY) / 1000000LU)
+    #define IDLE_MAX_TICKS              (((SchedulerTicks)SCHEDULER_IDLE_MAX_US * SYSTEM_TICK_FREQUENCY) / 1000000LU)
+    #define IDLE_INTERRUPT_PRIORITY     INTERRUPT_PRIORITY_1 // Only has to exceed the main loop priority to wake the core
+    #define sleepUntil(sleep, wake, now) (isDue(wake, now) ? 0 : ((((wake) - (now)) < (sleep)) ? ((wake) - (now)) : (sleep)))
+#endif
+
+struct Event;
+struct RobinTask;
+struct PostedWork;
+struct SchedulerProfile;
+
+static void schedule_next_period(struct Event* event);
+static void heap_push(struct Event* event);
+static struct Event* heap_pop();
+static void heap_remove(struct Event* event);
+static void heap_sift_up(size_t index);
+static void heap_sift_down(size_t index);
+static unsigned char heap_less(const struct Event* first, const struct Event* second);
+static void ready_push(struct Event* event);
+static struct Event* ready_pop();
+static void ready_remove(struct Event* event);
+#ifdef readyKey
+static unsigned char ready_before(const struct Event* first, const struct Event* second);
+#endif
+static struct Event* find_event(const SchedulerId id);
+static void unlink_event(struct Event* event);
+static struct RobinTask* find_robin_task(const SchedulerId id);
+static void robin_list_push(struct RobinTask* task);
+static void robin_list_remove(struct RobinTask* task);
+static bool post_push(const SchedulerPostHandle handle, void* arg, const bool reserved);
+static bool post_take(struct PostedWork* work);
+static SchedulerTicks current_ticks();
+static SchedulerTicks auto_phase(const SchedulerTicks interval);
+static SchedulerTicks phase_distance(const SchedulerTicks first, const SchedulerTicks second, const SchedulerTicks modulus);
+#ifdef SCHEDULER_PROFILING
+static void profile_reset(struct SchedulerProfile* profile);
+static void profile_record(struct SchedulerProfile* profile, const unsigned long cycles);
+static void profile_lateness(struct Event* event);
+static void profile_print(const char* type, const SchedulerId id, const struct SchedulerProfile* profile);
+#endif
+#ifdef SCHEDULER_CYCLIC_EXECUTIVE
+static void execute_frame();
+#endif
+#ifdef SCHEDULER_ROBIN_QUANTUM_US
+static struct RobinTask* robin_select();
+static void robin_account(struct RobinTask* task, const unsigned long cycles);
+static void robin_credit(struct RobinTask* task);
+#endif
+#ifdef SCHEDULER_LOAD_METER
+static void load_charge(const enum SchedulerLoad load);
+static void load_sample(const unsigned long now);
+#endif
+#ifdef SCHEDULER_TICKLESS_IDLE
+static void scheduler_idle();
+static bool post_pending();
+#endif
+
+#ifdef SCHEDULER_PROFILING
+struct SchedulerProfile
+{
+    unsigned long calls;
+    unsigned long minCycles; // Core timer cycles
+    unsigned long maxCycles;
+    unsigned long long totalCycles;
+    SchedulerTicks maxLateness; // System ticks between release and dispatch
+    SchedulerTicks totalLateness;
+};
+#endif
 
 struct Event
 {
     SchedulerHandle handle;
-    unsigned long interval;
-    unsigned long ticks;
-    unsigned int identifier;
+    SchedulerTicks interval;
+    SchedulerTicks release; // Absolute release time in system ticks
+    SchedulerTicks deadline; // Relative to the release, defaults to the interval
+    unsigned long missedPeriods;
+    unsigned long deadlineMisses;
+    struct Event* next; // Next event in the ready list, or in the free list when unassigned
+    size_t heapIndex;
+    unsigned short generation;
+#ifdef SCHEDULER_PROFILING
+    struct SchedulerProfile profile;
+#endif
     
     struct {
-        unsigned char priority :2;
-        unsigned char assigned :1;
-        unsigned char reserved :5;
+        unsigned char priority  :2;
+        unsigned char assigned  :1;
+        unsigned char ready     :1;
+        unsigned char catchUp   :2;
+        unsigned char suspended :1;
+        unsigned char reserved  :1;
     } opt;
 };
 
+#ifdef SCHEDULER_CYCLIC_EXECUTIVE
+struct StaticEvent
+{
+    SchedulerHandle handle;
+    unsigned short period; // In minor frames
+    unsigned short offset; // Minor frame within the period in which the event is executed
+};
+
+SCHEDULER_STATIC_EVENTS(staticEventPrototype)
+
+// Table order is the dispatch order within a minor frame, the sentinel keeps the initializer valid when the table expands to nothing
+static const struct StaticEvent staticEvents[] = { SCHEDULER_STATIC_EVENTS(staticEventEntry) { NULL, 1, 0 } };
+static const size_t nStaticEvents = sizeof(staticEvents) / sizeof(staticEvents[0]) - 1;
+static SchedulerTicks nextFrame = 0;
+static unsigned short minorFrame = 0;
+static unsigned long frameOverruns = 0;
+#endif
+
+struct PostedWork
+{
+    SchedulerPostHandle handle;
+    void* arg;
+};
+
+// Ring with a single producer (all interrupts of one priority level) and a single consumer (the scheduler)
+struct PostQueue
+{
+    struct PostedWork slots[POST_QUEUE_SIZE];
+    volatile size_t head; // Only written by the producer
+    volatile size_t tail; // Only written by the consumer
+    size_t reserved; // Slots left free by scheduler_post() for scheduler_post_reserved()
+};
+
 struct RobinTask
 {
     SchedulerHandle handle;
-    unsigned int identifier;
+    struct RobinTask* nextFree;
+    size_t listIndex; // Position in the dispatch list
+    unsigned short generation;
+#ifdef SCHEDULER_PROFILING
+    struct SchedulerProfile profile;
+#endif
+#ifdef SCHEDULER_ROBIN_QUANTUM_US
+    long deficit; // Core timer cycles the task may still use this round, negative while paying off an overrun
+    unsigned long budget; // Core timer cycles per call, '0' for unlimited
+    unsigned long long cycles; // Delivered core timer cycles
+    unsigned long overruns;
+    unsigned char weight;
+#endif
     struct {
-        unsigned char assigned :1;
-        unsigned char reserved :7;
+        unsigned char assigned  :1;
+        unsigned char suspended :1;
+        unsigned char demotion  :2; // Each level halves the weight
+        unsigned char overran   :1; // Overran its budget since the last credit
+        unsigned char reserved  :3;
     } opt;
 };
 
@@ -70,10 +380,12 @@ struct RobinTask
         #error "Maximum number of events is exceeded, increase maximum or lower the pool size."
     #else
         static struct Event eventPool[EVENT_POOL_SIZE];
+        static struct Event* eventHeap[EVENT_POOL_SIZE];
         static const size_t nEvents = EVENT_POOL_SIZE;
     #endif
 #else
     static struct Event eventPool[EVENT_DEF_POOL_SIZE];
+    static struct Event* eventHeap[EVENT_DEF_POOL_SIZE];
     static const unsigned int nEvents = EVENT_DEF_POOL_SIZE;
 #endif
     
@@ -84,43 +396,112 @@ struct RobinTask
         #error "Maximum number of robin tasks is exceeded, increase maximum or lower the pool size."
     #else
         static struct RobinTask robinTaskPool[ROBIN_TASK_POOL_SIZE];
+        static struct RobinTask* robinTaskList[ROBIN_TASK_POOL_SIZE];
         static const size_t nRobinTasks = ROBIN_TASK_POOL_SIZE;
     #endif
 #else
     static struct RobinTask robinTaskPool[ROBIN_TASK_DEF_POOL_SIZE];
+    static struct RobinTask* robinTaskList[ROBIN_TASK_DEF_POOL_SIZE];
     static const unsigned int nRobinTasks = ROBIN_TASK_DEF_POOL_SIZE;
 #endif
     
-static unsigned short lastTickCount = 0;
-static unsigned short elapsedTicks = 0;
-static unsigned short robinTaskOffset = 0;
-static unsigned short nValidEvents = 0;
-static unsigned short nValidRobinTasks = 0;
+// Pending events are kept in a min-heap on their release time, due events are moved to a FIFO per priority
+static struct Event* readyHead[READY_LIST_COUNT];
+static struct Event* readyTail[READY_LIST_COUNT];
+static struct PostQueue postQueues[POST_IPL_COUNT];
+
+// Unassigned pool items are kept in a free list, active robin tasks are kept dense in the dispatch list
+static struct Event* freeEvents = NULL;
+static struct RobinTask* freeRobinTasks = NULL;
+
+static SchedulerTicks systemTicks = 0;
+static unsigned long lastTickCount = 0;
+static unsigned long elapsedTicks = 0;
+static size_t robinTaskOffset = 0;
+#ifdef SCHEDULER_ROBIN_QUANTUM_US
+static unsigned long long robinCycles = 0; // Total core timer cycles delivered to robin tasks
+#endif
+static size_t nActiveRobinTasks = 0;
+static size_t nPendingEvents = 0;
+static unsigned long coalescedPeriods = 1;
+static SchedulerTicks idleTicks = 0;
+static SchedulerTicks idleWindowStart = 0;
+#ifdef SCHEDULER_LOAD_METER
+static unsigned long loadCycles[SCHEDULER_LOAD_COUNT]; // Core timer cycles of the current sample
+static unsigned long loadAverage[SCHEDULER_WINDOW_COUNT][SCHEDULER_LOAD_COUNT]; // Tenths of a percent, fixed point
+static const unsigned short loadWindowSamples[SCHEDULER_WINDOW_COUNT] = { 100 / SCHEDULER_LOAD_SAMPLE_MS, 1000 / SCHEDULER_LOAD_SAMPLE_MS, 10000 / SCHEDULER_LOAD_SAMPLE_MS };
+static unsigned long loadStamp = 0;
+static unsigned long loadIsrStamp = 0;
+static unsigned long loadSampleStart = 0;
+static volatile unsigned long isrCycles = 0;
+static unsigned long isrStart = 0;
+static unsigned char isrNesting = 0;
+#endif
 
 bool scheduler_init()
 {
     size_t i;
     
-    // Invalidate all items from the pools and set the identifier
-    for(i = 0; i < nEvents; ++i) {
+    // Invalidate all items from the pools and chain them into the free lists
+    freeEvents = NULL;
+    for(i = nEvents; i-- > 0;) {
         eventPool[i].opt.assigned = 0;
-        eventPool[i].identifier = i;
+        eventPool[i].generation = 1;
+        eventPool[i].next = freeEvents;
+        freeEvents = &eventPool[i];
     }
-    for(i = 0; i < nRobinTasks; ++i) {
+    freeRobinTasks = NULL;
+    for(i = nRobinTasks; i-- > 0;) {
         robinTaskPool[i].opt.assigned = 0;
-        robinTaskPool[i].identifier = i;
+        robinTaskPool[i].generation = 1;
+        robinTaskPool[i].nextFree = freeRobinTasks;
+        freeRobinTasks = &robinTaskPool[i];
+    }
+    for(i = 0; i < READY_LIST_COUNT; ++i) {
+        readyHead[i] = NULL;
+        readyTail[i] = NULL;
+    }
+    for(i = 0; i < POST_IPL_COUNT; ++i) {
+        postQueues[i].head = 0;
+        postQueues[i].tail = 0;
+        postQueues[i].reserved = 0;
     }
     
     // Initialize variables
+    systemTicks = 0;
     lastTickCount = 0;
     elapsedTicks = 0;
     robinTaskOffset = 0;
-    nValidEvents = 0;
-    nValidRobinTasks = 0;
+#ifdef SCHEDULER_ROBIN_QUANTUM_US
+    robinCycles = 0;
+#endif
+    nActiveRobinTasks = 0;
+    nPendingEvents = 0;
+    coalescedPeriods = 1;
+    idleTicks = 0;
+    idleWindowStart = 0;
+#ifdef SCHEDULER_LOAD_METER
+    for(i = 0; i < SCHEDULER_LOAD_COUNT; ++i) {
+        size_t window;
+        loadCycles[i] = 0;
+        for(window = 0; window < SCHEDULER_WINDOW_COUNT; ++window)
+            loadAverage[window][i] = 0;
+    }
+    loadStamp = _CP0_GET_COUNT();
+    loadIsrStamp = isrCycles;
+    loadSampleStart = loadStamp;
+#endif
+#ifdef SCHEDULER_CYCLIC_EXECUTIVE
+    nextFrame = 0;
+    minorFrame = 0;
+    frameOverruns = 0;
+#endif
     
-    // Configure timer
+    // Configure timer, free running over its full width
     HW_TIMER_CFG_REG &= ~(1 << HW_TIMER_CFG_EN_BIT);
     HW_TIMER_CFG_REG = HW_TIMER_CFG_WORD;
+    HW_TIMER_PR_REG = HW_TIMER_MASK;
+    HW_TIMER = 0;
     HW_TIMER_CFG_REG |= 1 << HW_TIMER_CFG_EN_BIT;
     
     return true;
@@ -129,205 +510,964 @@ bool scheduler_init()
 void scheduler_execute()
 {
     SchedulerHandle handle = NULL;
+    struct RobinTask* task = NULL;
+    struct PostedWork work = { NULL, NULL };
+    SchedulerTicks jobDeadline = 0;
     
-     // Calculate elapsed ticks since last call
-    elapsedTicks = HW_TIMER - lastTickCount;
-    lastTickCount += elapsedTicks;
-    
-    // Service events
-    struct Event* event = eventPool; // Pool will always contain atleast one item
-    while(event->opt.assigned) { // Eventpool will always be contiguous with valid events
-        if(event->ticks <= elapsedTicks) {
-            if(handle == NULL) {
-                event->ticks = event->interval;
-                handle = event->handle;
-            } else
-                event->ticks = 0;
-        } else
-            event->ticks -= elapsedTicks;
-        
-        // Increment event pointer
-        event++;
+     // Calculate elapsed ticks since last call and extend them into the 64 bit system tick count
+    elapsedTicks = (HW_TIMER - lastTickCount) & HW_TIMER_MASK;
+    lastTickCount = (lastTickCount + elapsedTicks) & HW_TIMER_MASK;
+    systemTicks += elapsedTicks;
+
+    // Everything since the end of the previous pass is main loop overhead
+    loadCharge(SCHEDULER_LOAD_OVERHEAD);
+
+#ifdef SCHEDULER_CYCLIC_EXECUTIVE
+    // A minor frame boundary takes precedence over everything else, events are released on the next pass
+    if(nStaticEvents > 0 && isDue(nextFrame, systemTicks)) {
+        meteredCall(SCHEDULER_LOAD_EVENTS, execute_frame());
+        return;
     }
+#endif
+    
+    // Release due events, the heap top expires first so this is a single compare when nothing is due
+    while(nPendingEvents > 0 && isDue(eventHeap[0]->release, systemTicks))
+        ready_push(heap_pop());
+    
+    // Service events, most urgent first
+    struct Event* event = ready_pop();
+    if(event != NULL) {
+#ifdef SCHEDULER_DISPATCH_BUDGET_US
+        // Keep executing ready events until the budget is spent, the remainder stays ready for the next pass
+        const unsigned long start = _CP0_GET_COUNT();
+        do {
+            handle = event->handle;
+            jobDeadline = event->release + event->deadline;
+            profileLateness(event);
+            schedule_next_period(event);
+            heap_push(event);
+            meteredCall(SCHEDULER_LOAD_EVENTS, profiledCall(&event->profile, (*handle)()));
+            if(isBefore(jobDeadline, current_ticks()))
+                event->deadlineMisses++; // Completed after its absolute deadline
+        } while((_CP0_GET_COUNT() - start) < DISPATCH_BUDGET_CYCLES && (event = ready_pop()) != NULL);
+        return; // Deferred work and robin tasks are serviced on the next pass
+#else
+        jobDeadline = event->release + event->deadline;
+        profileLateness(event);
+        schedule_next_period(event);
+        heap_push(event);
+        handle = event->handle;
+#endif
+    }
+    
+    // Service deferred work posted by interrupts, this takes precedence over robin tasks
+    if(handle == NULL)
+        post_take(&work);
     
     // Service robin tasks
-    if(handle == NULL) {
-        struct RobinTask* task = &robinTaskPool[robinTaskOffset]; // Pool will always contain atleast one item
-        if(task->opt.assigned) {
-            handle = task->handle;
-            robinTaskOffset++;
-        } else 
+    if(handle == NULL && work.handle == NULL && nActiveRobinTasks > 0) {
+#ifdef SCHEDULER_ROBIN_QUANTUM_US
+        task = robin_select();
+#else
+        if(robinTaskOffset >= nActiveRobinTasks)
             robinTaskOffset = 0;
+        task = robinTaskList[robinTaskOffset++];
+#endif
+        handle = task->handle;
     }
     
     // Yay, finally execute handle!
-    if(handle != NULL)
-        (*handle)();
+    if(handle != NULL) {
+#ifdef SCHEDULER_ROBIN_QUANTUM_US
+        const unsigned long start = _CP0_GET_COUNT();
+#endif
+        meteredCall((event != NULL) ? SCHEDULER_LOAD_EVENTS : SCHEDULER_LOAD_ROBIN, profiledCall((event != NULL) ? &event->profile : &task->profile, (*handle)()));
+        if(event != NULL && isBefore(jobDeadline, current_ticks()))
+            event->deadlineMisses++; // Completed after its absolute deadline
+#ifdef SCHEDULER_ROBIN_QUANTUM_US
+        if(task != NULL)
+            robin_account(task, _CP0_GET_COUNT() - start);
+#endif
+    } else if(work.handle != NULL)
+        meteredCall(SCHEDULER_LOAD_DEFERRED, (*work.handle)(work.arg));
+#ifdef SCHEDULER_TICKLESS_IDLE
+    else if(nActiveRobinTasks == 0)
+        meteredCall(SCHEDULER_LOAD_IDLE, scheduler_idle()); // Nothing ready and no robin tasks to spin on, sleep until the next release
+#else
+    else
+        loadCharge(SCHEDULER_LOAD_IDLE); // Nothing to execute, the whole pass is spent spinning
+#endif
 }
 
-struct Event* scheduler_create_event(const SchedulerHandle handle, const unsigned short interval, const enum SchedulerIntervalUnit unit, const unsigned char priority)
+SchedulerId scheduler_create_event(const SchedulerHandle handle, const unsigned long interval, const enum SchedulerIntervalUnit unit, const unsigned char priority)
 {
-    struct Event* event = NULL;
+    return scheduler_create_event_phased(handle, interval, DEFAULT_PHASE, unit, priority);
+}
+
+SchedulerId scheduler_create_event_phased(const SchedulerHandle handle, const unsigned long interval, const unsigned long phase, const enum SchedulerIntervalUnit unit, const unsigned char priority)
+{
+    struct Event* event = freeEvents;
     
-    if(handle == NULL || nValidEvents >= nEvents)
-        return event;
+    if(handle == NULL || event == NULL)
+        return SCHEDULER_ID_INVALID;
     
+    freeEvents = event->next;
+    event->handle = handle;
+    event->interval = scheduler_calc_ticks(interval, unit);
+    if(phase == SCHEDULER_PHASE_AUTO)
+        event->release = systemTicks + auto_phase(event->interval);
+    else
+        event->release = systemTicks + scheduler_calc_ticks(phase, unit); // A phase of '0' expires on the next pass
+    event->deadline = event->interval;
+    event->missedPeriods = 0;
+    event->deadlineMisses = 0;
+    event->next = NULL;
+    event->opt.priority = (priority < EVENT_PRIO_COUNT) ? priority : PRIO_LOW;
+    event->opt.ready = 0;
+    event->opt.catchUp = SCHEDULER_CATCH_UP_SKIP;
+    event->opt.suspended = 0;
+    event->opt.assigned = 1;
+#ifdef SCHEDULER_PROFILING
+    profile_reset(&event->profile);
+#endif
+    heap_push(event);
+    return makeId(event->generation, event - eventPool);
+}
+
+void scheduler_remove_event(const SchedulerId id)
+{
+    struct Event* event = find_event(id);
+    if(event == NULL)
+        return;
+    
+    unlink_event(event);
+    event->opt.assigned = 0; // Invalidate event
+    event->generation = nextGeneration(event->generation); // Invalidate all identifiers still referring to this event
+    event->next = freeEvents;
+    freeEvents = event;
+}
+
+void scheduler_suspend_event(const SchedulerId id)
+{
+    struct Event* event = find_event(id);
+    if(event == NULL || event->opt.suspended)
+        return;
+    
+    unlink_event(event);
+    event->opt.suspended = 1;
+}
+
+void scheduler_resume_event(const SchedulerId id)
+{
+    struct Event* event = find_event(id);
+    if(event == NULL || !event->opt.suspended)
+        return;
+    
+    event->opt.suspended = 0;
+    event->release = systemTicks; // Expire on the next pass
+    heap_push(event);
+}
+
+void scheduler_set_catch_up(const SchedulerId id, const enum SchedulerCatchUp catchUp)
+{
+    struct Event* event = find_event(id);
+    if(event != NULL)
+        event->opt.catchUp = catchUp;
+}
+
+unsigned long scheduler_missed_periods(const SchedulerId id)
+{
+    unsigned long result = 0;
+    struct Event* event = find_event(id);
+    if(event != NULL)
+        result = event->missedPeriods;
+    return result;
+}
+
+void scheduler_set_deadline(const SchedulerId id, const unsigned long deadline, const enum SchedulerIntervalUnit unit)
+{
+    struct Event* event = find_event(id);
+    if(event != NULL)
+        event->deadline = scheduler_calc_ticks(deadline, unit);
+}
+
+unsigned long scheduler_deadline_misses(const SchedulerId id)
+{
+    unsigned long result = 0;
+    struct Event* event = find_event(id);
+    if(event != NULL)
+        result = event->deadlineMisses;
+    return result;
+}
+
+unsigned long scheduler_frame_overruns()
+{
+#ifdef SCHEDULER_CYCLIC_EXECUTIVE
+    return frameOverruns;
+#else
+    return 0;
+#endif
+}
+
+unsigned long scheduler_coalesced_periods()
+{
+    return coalescedPeriods;
+}
+
+SchedulerTicks scheduler_get_ticks()
+{
+    return systemTicks;
+}
+
+bool scheduler_post(const SchedulerPostHandle handle, void* arg)
+{
+    return post_push(handle, arg, false);
+}
+    
+bool scheduler_reserve_post(const unsigned char priority)
+{
+    if(priority >= POST_IPL_COUNT || postQueues[priority].reserved + 1 >= POST_QUEUE_SIZE)
+        return false; // A single slot is always left for scheduler_post()
+    
+    postQueues[priority].reserved++;
+    return true;
+}
+
+bool scheduler_post_reserved(const SchedulerPostHandle handle, void* arg)
+{
+    return post_push(handle, arg, true);
+}
+
+void scheduler_print_profile()
+{
+#ifdef SCHEDULER_PROFILING
     size_t i;
+    
+    print_f("Id\t\tCalls\tMin\tAvg\tMax\tLate avg (us)\tLate max (us)\r\n");
     for(i = 0; i < nEvents; ++i) {
-        if(!eventPool[i].opt.assigned) {
-            event = &eventPool[i];
-            break;
-        }
+        if(eventPool[i].opt.assigned)
+            profile_print("E", makeId(eventPool[i].generation, i), &eventPool[i].profile);
+    }
+    for(i = 0; i < nRobinTasks; ++i) {
+        if(robinTaskPool[i].opt.assigned)
+            profile_print("R", makeId(robinTaskPool[i].generation, i), &robinTaskPool[i].profile);
     }
+#endif
+}
+
+unsigned char scheduler_idle_percentage()
+{
+    unsigned char percentage = 0;
+    SchedulerTicks window = systemTicks - idleWindowStart;
     
-    if(event != NULL) {
-        event->handle = handle;
-        event->interval = calc_sys_ticks(interval, unit);
-        event->ticks = 0;
-        event->opt.priority = priority;
-        event->opt.assigned = 1;
-        nValidEvents++;
-        unsigned int identifier = event->identifier;
-        sort_events(); // Might cause the event pointer to change
-        event = find_event(identifier);
+    if(window > 0)
+        percentage = (idleTicks >= window) ? 100 : (unsigned char)((idleTicks * 100) / window);
+    
+    // Start a new measurement window
+    idleWindowStart = systemTicks;
+    idleTicks = 0;
+    return percentage;
+}
+
+unsigned short scheduler_load(const enum SchedulerLoad load, const enum SchedulerLoadWindow window)
+{
+#ifdef SCHEDULER_LOAD_METER
+    if(load < SCHEDULER_LOAD_COUNT && window < SCHEDULER_WINDOW_COUNT)
+        return (unsigned short)((loadAverage[window][load] + (1LU << (LOAD_FRACTION_BITS - 1))) >> LOAD_FRACTION_BITS);
+#endif
+    return 0;
+}
+
+void scheduler_print_load()
+{
+#ifdef SCHEDULER_LOAD_METER
+    static const char* const names[SCHEDULER_LOAD_COUNT] = { "Events", "Deferred", "Robin", "ISR", "Idle", "Overhead" };
+    size_t i;
+    
+    print_f("Load (permille)\t100 ms\t1 s\t10 s\r\n");
+    for(i = 0; i < SCHEDULER_LOAD_COUNT; ++i) {
+        print_f("%s\t%d\t%d\t%d\r\n", names[i],
+                scheduler_load(i, SCHEDULER_WINDOW_100MS),
+                scheduler_load(i, SCHEDULER_WINDOW_1S),
+                scheduler_load(i, SCHEDULER_WINDOW_10S));
     }
-    return event;
+#endif
 }
 
-void scheduler_remove_event(struct Event* event)
+void scheduler_isr_enter()
 {
-    if(event == NULL)
+#ifdef SCHEDULER_LOAD_METER
+    if(isrNesting++ == 0)
+        isrStart = _CP0_GET_COUNT(); // Only the outermost interrupt is timed, nested ones are part of it
+#endif
+}
+
+void scheduler_isr_exit()
+{
+#ifdef SCHEDULER_LOAD_METER
+    if(isrNesting > 0 && --isrNesting == 0)
+        isrCycles += _CP0_GET_COUNT() - isrStart;
+#endif
+}
+
+SchedulerTicks scheduler_calc_ticks(const unsigned long time, const enum SchedulerIntervalUnit unit)
+{
+    SchedulerTicks ticks;
+    switch(unit) {
+        default: // Default to microseconds
+        case SCHEDULER_UNIT_US: ticks = ((SchedulerTicks)time * SYSTEM_TICK_FREQUENCY) / 1000000LU;   break;
+        case SCHEDULER_UNIT_MS: ticks = ((SchedulerTicks)time * SYSTEM_TICK_FREQUENCY) / 1000LU;      break;
+        case SCHEDULER_UNIT_S:  ticks = ((SchedulerTicks)time * SYSTEM_TICK_FREQUENCY);               break;
+    }
+    return ticks;
+}
+
+SchedulerId scheduler_create_robin_task(const SchedulerHandle handle)
+{
+    struct RobinTask* task = freeRobinTasks;
+    
+    if(handle == NULL || task == NULL)
+        return SCHEDULER_ID_INVALID;
+    
+    freeRobinTasks = task->nextFree;
+    task->handle = handle;
+#ifdef SCHEDULER_ROBIN_QUANTUM_US
+    task->budget = 0;
+    task->cycles = 0;
+    task->overruns = 0;
+    task->weight = 1;
+    task->opt.demotion = 0;
+    task->opt.overran = 0;
+    task->deficit = robinQuantum(task);
+#endif
+    task->opt.suspended = 0;
+    task->opt.assigned = 1;
+#ifdef SCHEDULER_PROFILING
+    profile_reset(&task->profile);
+#endif
+    robin_list_push(task);
+    return makeId(task->generation, task - robinTaskPool);
+}
+
+void scheduler_remove_robin_task(const SchedulerId id)
+{
+    struct RobinTask* task = find_robin_task(id);
+    if(task == NULL)
         return;
     
-    if(event->opt.assigned)
-        event->opt.assigned = 0; // Invalidate event
+    if(!task->opt.suspended)
+        robin_list_remove(task);
+    task->opt.assigned = 0; // Invalidate robin task
+    task->generation = nextGeneration(task->generation); // Invalidate all identifiers still referring to this robin task
+    task->nextFree = freeRobinTasks;
+    freeRobinTasks = task;
 }
 
-struct RobinTask* scheduler_create_robin_task(const SchedulerHandle handle)
+void scheduler_suspend_robin_task(const SchedulerId id)
 {
-    struct RobinTask* task = NULL;
+    struct RobinTask* task = find_robin_task(id);
+    if(task == NULL || task->opt.suspended)
+        return;
     
-    if(handle == NULL || nValidRobinTasks >= nRobinTasks)
-        return task;
+    robin_list_remove(task);
+    task->opt.suspended = 1;
+}
+
+void scheduler_resume_robin_task(const SchedulerId id)
+{
+    struct RobinTask* task = find_robin_task(id);
+    if(task == NULL || !task->opt.suspended)
+        return;
     
+    task->opt.suspended = 0;
+#ifdef SCHEDULER_ROBIN_QUANTUM_US
+    task->deficit = robinQuantum(task);
+#endif
+    robin_list_push(task);
+}
+
+void scheduler_set_robin_weight(const SchedulerId id, const unsigned char weight)
+{
+#ifdef SCHEDULER_ROBIN_QUANTUM_US
+    struct RobinTask* task = find_robin_task(id);
+    if(task != NULL)
+        task->weight = (weight > 0) ? weight : 1;
+#endif
+}
+
+void scheduler_set_robin_budget(const SchedulerId id, const unsigned long budget, const enum SchedulerIntervalUnit unit)
+{
+#ifdef SCHEDULER_ROBIN_QUANTUM_US
+    struct RobinTask* task = find_robin_task(id);
+    if(task != NULL)
+        task->budget = (unsigned long)((scheduler_calc_ticks(budget, unit) * CORE_TICK_FREQUENCY) / SYSTEM_TICK_FREQUENCY);
+#endif
+}
+
+unsigned long scheduler_robin_overruns(const SchedulerId id)
+{
+    unsigned long result = 0;
+#ifdef SCHEDULER_ROBIN_QUANTUM_US
+    struct RobinTask* task = find_robin_task(id);
+    if(task != NULL)
+        result = task->overruns;
+#endif
+    return result;
+}
+
+unsigned short scheduler_robin_share(const SchedulerId id)
+{
+    unsigned short result = 0;
+#ifdef SCHEDULER_ROBIN_QUANTUM_US
+    struct RobinTask* task = find_robin_task(id);
+    if(task != NULL && robinCycles > 0)
+        result = (unsigned short)((task->cycles * 1000) / robinCycles);
+#endif
+    return result;
+}
+
+void scheduler_print_robin_shares()
+{
+#ifdef SCHEDULER_ROBIN_QUANTUM_US
     size_t i;
+    
+    print_f("Handle\tWeight\tDemoted\tShare (permille)\tOverruns\r\n");
     for(i = 0; i < nRobinTasks; ++i) {
-        if(!robinTaskPool[i].opt.assigned) {
-            task = &robinTaskPool[i];
-            break;
+        const struct RobinTask* task = &robinTaskPool[i];
+        if(task->opt.assigned) {
+            print_f("R%d\t%d\t%d\t%d\t%d\r\n", i, task->weight, task->opt.demotion,
+                    (robinCycles > 0) ? (unsigned long)((task->cycles * 1000) / robinCycles) : 0,
+                    task->overruns);
         }
     }
+#endif
+}
+
+#ifdef SCHEDULER_TICKLESS_IDLE
+void scheduler_idle()
+{
+    SchedulerTicks sleep = IDLE_MAX_TICKS;
+    
+    // Interrupts are held off until after WAIT, a pending interrupt still wakes the core but is serviced afterwards
+    interrupt_global_disable();
     
-    if(task != NULL) {
-        task->handle = handle;
-        task->opt.assigned = 1;
-        nValidRobinTasks++;
-        unsigned int identifier = task->identifier;
-        sort_robin_tasks(); // Might cause the event pointer to change
-        task = find_robin_task(identifier);
+    // The handle executed during this pass may have taken a while, so sample the current time again
+    unsigned long start = HW_TIMER;
+    SchedulerTicks now = current_ticks();
+    if(post_pending())
+        sleep = 0;
+    else {
+        if(nPendingEvents > 0)
+            sleep = sleepUntil(sleep, eventHeap[0]->release, now);
+#ifdef SCHEDULER_CYCLIC_EXECUTIVE
+        if(nStaticEvents > 0)
+            sleep = sleepUntil(sleep, nextFrame, now);
+#endif
     }
-    return task;
+    
+    if(sleep >= IDLE_MIN_TICKS) {
+        // Arm the core timer compare as wake-up source, any other enabled interrupt wakes the core as well
+        _CP0_SET_COMPARE(_CP0_GET_COUNT() + (unsigned long)((sleep * CORE_TICK_FREQUENCY) / SYSTEM_TICK_FREQUENCY));
+        interrupt_clr_flag(INTERRUPT_CORE_TIMER);
+        interrupt_enable(INTERRUPT_CORE_TIMER, IDLE_INTERRUPT_PRIORITY);
+        _wait();
+        interrupt_disable(INTERRUPT_CORE_TIMER);
+        interrupt_clr_flag(INTERRUPT_CORE_TIMER);
+        idleTicks += (HW_TIMER - start) & HW_TIMER_MASK;
+    }
+    
+    interrupt_global_enable();
 }
+#endif
 
-void scheduler_remove_robin_task(struct RobinTask* task)
+#ifdef SCHEDULER_ROBIN_QUANTUM_US
+struct RobinTask* robin_select()
 {
-    if(task == NULL)
-        return;
+    size_t visits = 0;
+    
+    if(robinTaskOffset >= nActiveRobinTasks)
+        robinTaskOffset = 0;
+    struct RobinTask* task = robinTaskList[robinTaskOffset];
+    
+    // Tasks still paying off an overrun are passed over, each visit credits them another quantum
+    while(task->deficit <= 0 && visits++ < nActiveRobinTasks) {
+        robinTaskOffset = (robinTaskOffset + 1 < nActiveRobinTasks) ? robinTaskOffset + 1 : 0;
+        task = robinTaskList[robinTaskOffset];
+        robin_credit(task);
+    }
     
-    if(task->opt.assigned)
-        task->opt.assigned = 0; // Invalidate event
+    return task;
 }
 
-unsigned long calc_sys_ticks(unsigned short time, enum SchedulerIntervalUnit unit)
+void robin_account(struct RobinTask* task, const unsigned long cycles)
 {
-    unsigned long ticks;
-    switch(unit) {
-        default: // Default to microseconds
-        case SCHEDULER_UNIT_US: ticks = time / SYSTEM_TICK;                 break;
-        case SCHEDULER_UNIT_MS: ticks = (time * 1000LU) / SYSTEM_TICK;      break;
-        case SCHEDULER_UNIT_S:  ticks = (time * 1000000LU) / SYSTEM_TICK;   break; // @Todo: overflow might be possible!
+    task->cycles += cycles;
+    robinCycles += cycles;
+    task->deficit -= (long)cycles;
+    
+    if(task->budget > 0 && cycles > task->budget) {
+        task->overruns++;
+        task->opt.overran = 1;
+        if(task->opt.demotion < ROBIN_MAX_DEMOTION)
+            task->opt.demotion++;
+    }
+    
+    // The task keeps the next passes until its quantum is used up, then the next task is credited
+    if(task->deficit <= 0 && nActiveRobinTasks > 0) {
+        robinTaskOffset = (task->listIndex + 1 < nActiveRobinTasks) ? task->listIndex + 1 : 0;
+        robin_credit(robinTaskList[robinTaskOffset]);
     }
-    return ticks;
 }
 
-void sort_events()
-{
-    unsigned short outer;
-    unsigned short inner;
-    struct Event* current;
-    struct Event* next;
-    struct Event temp;
-    
-    // Sort so that all the valid events are the first entries in the pool
-    for(outer = 0; outer < nEvents; ++outer) {
-        for(inner = 0; inner < (nEvents - outer - 1); ++inner) {
-            current = &eventPool[inner];
-            next = &eventPool[inner + 1];
-            if(current->opt.assigned < next->opt.assigned) {
-                temp = *next;
-                *next = *current;
-                *current = temp;
-            }
+void robin_credit(struct RobinTask* task)
+{
+    if(!task->opt.overran && task->opt.demotion > 0)
+        task->opt.demotion--; // A whole round within budget, restore one level
+    task->opt.overran = 0;
+    
+    // Unused time does not accumulate over rounds, a debt is paid off over several rounds
+    task->deficit += robinQuantum(task);
+    if(task->deficit > robinQuantum(task))
+        task->deficit = robinQuantum(task);
+}
+#endif
+
+#ifdef SCHEDULER_LOAD_METER
+void load_charge(const enum SchedulerLoad load)
+{
+    const unsigned long now = _CP0_GET_COUNT();
+    const unsigned long isr = isrCycles;
+    unsigned long elapsed = now - loadStamp;
+    unsigned long interrupted = isr - loadIsrStamp;
+    
+    // Interrupt time is taken out of whatever was interrupted
+    if(interrupted > elapsed)
+        interrupted = elapsed; // Part of the interrupt started before the previous stamp
+    loadCycles[load] += elapsed - interrupted;
+    loadCycles[SCHEDULER_LOAD_ISR] += interrupted;
+    loadStamp = now;
+    loadIsrStamp = isr;
+    
+    if((now - loadSampleStart) >= LOAD_SAMPLE_CYCLES)
+        load_sample(now);
+}
+
+void load_sample(const unsigned long now)
+{
+    const unsigned long total = now - loadSampleStart;
+    const unsigned long samples = total / LOAD_SAMPLE_CYCLES; // Idle mode may cover several sample periods
+    size_t i, window;
+    
+    for(i = 0; i < SCHEDULER_LOAD_COUNT; ++i) {
+        const long value = (long)((((unsigned long long)loadCycles[i] * 1000) / total) << LOAD_FRACTION_BITS);
+        
+        // Exponential moving average with a weight of one sample per window, applied once for each sample period covered
+        for(window = 0; window < SCHEDULER_WINDOW_COUNT; ++window) {
+            long average = (long)loadAverage[window][i];
+            unsigned long n = (samples < loadWindowSamples[window]) ? samples : loadWindowSamples[window];
+            while(n-- > 0)
+                average += (value - average) / (long)loadWindowSamples[window];
+            loadAverage[window][i] = (unsigned long)average;
         }
+        loadCycles[i] = 0;
     }
     
-    // Lastly sort so that the priorities are from high to low
-    for(outer = 0; outer < nValidEvents; ++outer) {        
-        for(inner = 0; inner < (nValidEvents - outer - 1); ++inner) {
-            current = &eventPool[inner];
-            next = &eventPool[inner + 1];
-            if(current->opt.priority > next->opt.priority) {
-                temp = *next;
-                *next = *current;
-                *current = temp;
-            }
+    loadSampleStart = now;
+}
+#endif
+
+#ifdef SCHEDULER_CYCLIC_EXECUTIVE
+void execute_frame()
+{
+    size_t i;
+    const struct StaticEvent* event = staticEvents;
+    
+    for(i = 0; i < nStaticEvents; ++i) {
+        if((minorFrame % event->period) == event->offset)
+            (*event->handle)();
+        event++;
+    }
+    
+    // Advance to the next minor frame
+    nextFrame += MINOR_FRAME_TICKS;
+    minorFrame = (minorFrame + 1) % SCHEDULER_MAJOR_FRAME;
+    
+    // Frames that have already passed entirely are skipped and counted as overruns, the table stays aligned to the frame grid
+    SchedulerTicks now = current_ticks();
+    if(isDue(nextFrame + MINOR_FRAME_TICKS, now)) {
+        SchedulerTicks skipped = (now - nextFrame) / MINOR_FRAME_TICKS;
+        frameOverruns += skipped;
+        nextFrame += skipped * MINOR_FRAME_TICKS;
+        minorFrame = (minorFrame + skipped) % SCHEDULER_MAJOR_FRAME;
+    }
+}
+#endif
+
+SchedulerTicks auto_phase(const SchedulerTicks interval)
+{
+    SchedulerTicks best = 0;
+    SchedulerTicks bestDistance = 0;
+    SchedulerTicks step = interval / PHASE_CANDIDATES;
+    size_t i, j;
+    
+    if(step == 0)
+        return 0;
+    
+    // Pick the candidate phase whose releases stay farthest from the releases of all other events
+    for(i = 0; i < PHASE_CANDIDATES; ++i) {
+        SchedulerTicks release = systemTicks + i * step;
+        SchedulerTicks distance = interval;
+        
+        for(j = 0; j < nEvents; ++j) {
+            const struct Event* other = &eventPool[j];
+            if(!other->opt.assigned || other->opt.suspended || other->interval == 0)
+                continue;
+            
+            // Exact for harmonic intervals, where releases repeat on the shortest of both intervals
+            SchedulerTicks modulus = (other->interval < interval) ? other->interval : interval;
+            SchedulerTicks d = phase_distance(release, other->release, modulus);
+            if(d < distance)
+                distance = d;
+        }
+        
+        if(distance > bestDistance) {
+            best = i * step;
+            bestDistance = distance;
         }
     }
+    
+    return best;
 }
 
-struct Event* find_event(unsigned int identifier)
+SchedulerTicks phase_distance(const SchedulerTicks first, const SchedulerTicks second, const SchedulerTicks modulus)
+{
+    SchedulerTicks d = (isBefore(first, second) ? (second - first) : (first - second)) % modulus;
+    return (d < modulus - d) ? d : (modulus - d);
+}
+
+void schedule_next_period(struct Event* event)
+{
+    SchedulerTicks late = systemTicks - event->release; // Event is due, so this never wraps
+    SchedulerTicks periods = 0;
+    
+    // Determine how many whole periods passed beyond the release being serviced
+    if(event->interval > 0 && late >= event->interval)
+        periods = late / event->interval;
+    
+    coalescedPeriods = 1;
+    switch(event->opt.catchUp) {
+        default: // Default to skip
+        case SCHEDULER_CATCH_UP_SKIP:
+            event->missedPeriods += periods;
+            event->release += (periods + 1) * event->interval;
+            break;
+        case SCHEDULER_CATCH_UP_BURST:
+            if(periods > 0) // Each late execution is counted once, the remaining periods follow on the next passes
+                event->missedPeriods++;
+            event->release += event->interval;
+            break;
+        case SCHEDULER_CATCH_UP_COALESCE:
+            event->missedPeriods += periods;
+            coalescedPeriods += periods;
+            event->release += (periods + 1) * event->interval;
+            break;
+    }
+}
+
+void heap_push(struct Event* event)
+{
+    event->heapIndex = nPendingEvents;
+    eventHeap[nPendingEvents++] = event;
+    heap_sift_up(event->heapIndex);
+}
+    
+struct Event* heap_pop()
+{
+    struct Event* event = eventHeap[0];
+    heap_remove(event);
+    return event;
+}
+
+void heap_remove(struct Event* event)
+{
+    size_t index = event->heapIndex;
+    struct Event* last = eventHeap[--nPendingEvents];
+    
+    if(event == last)
+        return;
+    
+    // Fill the gap with the last event and restore the heap in whichever direction is needed
+    eventHeap[index] = last;
+    last->heapIndex = index;
+    if(index > 0 && heap_less(last, eventHeap[(index - 1) >> 1]))
+        heap_sift_up(index);
+    else
+        heap_sift_down(index);
+}
+
+void heap_sift_up(size_t index)
+{
+    struct Event* event = eventHeap[index];
+    
+    while(index > 0) {
+        size_t parent = (index - 1) >> 1;
+        if(!heap_less(event, eventHeap[parent]))
+            break;
+        eventHeap[index] = eventHeap[parent];
+        eventHeap[index]->heapIndex = index;
+        index = parent;
+    }
+    eventHeap[index] = event;
+    event->heapIndex = index;
+}
+
+void heap_sift_down(size_t index)
+{
+    struct Event* event = eventHeap[index];
+    
+    while(true) {
+        size_t child = (index << 1) + 1;
+        if(child >= nPendingEvents)
+            break;
+        if(child + 1 < nPendingEvents && heap_less(eventHeap[child + 1], eventHeap[child]))
+            child++;
+        if(!heap_less(eventHeap[child], event))
+            break;
+        eventHeap[index] = eventHeap[child];
+        eventHeap[index]->heapIndex = index;
+        index = child;
+    }
+    eventHeap[index] = event;
+    event->heapIndex = index;
+}
+
+unsigned char heap_less(const struct Event* first, const struct Event* second)
+{
+    if(first->release != second->release)
+        return isBefore(first->release, second->release);
+    return first->opt.priority < second->opt.priority;
+}
+
+void ready_push(struct Event* event)
+{
+    const size_t list = readyList(event);
+    
+    event->opt.ready = 1;
+#ifdef readyKey
+    // Insert behind all events that are at least as urgent, equal keys are served on priority and then in FIFO order
+    struct Event* previous = NULL;
+    struct Event* current = readyHead[list];
+    while(current != NULL && !ready_before(event, current)) {
+        previous = current;
+        current = current->next;
+    }
+    
+    event->next = current;
+    if(previous != NULL)
+        previous->next = event;
+    else
+        readyHead[list] = event;
+    if(current == NULL)
+        readyTail[list] = event;
+#else
+    event->next = NULL;
+    if(readyTail[list] != NULL)
+        readyTail[list]->next = event;
+    else
+        readyHead[list] = event;
+    readyTail[list] = event;
+#endif
+}
+
+struct Event* ready_pop()
 {
     struct Event* event = NULL;
     size_t i;
-    for(i = 0; i < nEvents; ++i) {
-        if(eventPool[i].identifier == identifier) {
-            event = &eventPool[i];
+    
+    // Most urgent list first
+    for(i = 0; i < READY_LIST_COUNT; ++i) {
+        event = readyHead[i];
+        if(event != NULL) {
+            readyHead[i] = event->next;
+            if(readyHead[i] == NULL)
+                readyTail[i] = NULL;
+            event->opt.ready = 0;
             break;
         }
     }
     return event;
 }
 
-void sort_robin_tasks()
+void ready_remove(struct Event* event)
 {
-    unsigned short outer;
-    unsigned short inner;
-    struct RobinTask* current;
-    struct RobinTask* next;
-    struct RobinTask temp;
+    const size_t list = readyList(event);
+    struct Event* previous = NULL;
+    struct Event* current = readyHead[list];
     
-    for(outer = 0; outer < nRobinTasks; ++outer) {
-        for(inner = 0; inner < (nRobinTasks - outer - 1); ++inner) {
-            current = &robinTaskPool[inner];
-            next = &robinTaskPool[inner + 1];
-            if(current->opt.assigned < next->opt.assigned) {
-                temp = *next;
-                *next = *current;
-                *current = temp;
-            }
+    while(current != NULL && current != event) {
+        previous = current;
+        current = current->next;
+    }
+    
+    if(current != NULL) {
+        if(previous != NULL)
+            previous->next = current->next;
+        else
+            readyHead[list] = current->next;
+        if(readyTail[list] == current)
+            readyTail[list] = previous;
+        event->opt.ready = 0;
+    }
+}
+
+#ifdef readyKey
+unsigned char ready_before(const struct Event* first, const struct Event* second)
+{
+    if(readyKey(first) != readyKey(second))
+        return isBefore(readyKey(first), readyKey(second));
+    return first->opt.priority < second->opt.priority;
+}
+#endif
+
+bool post_push(const SchedulerPostHandle handle, void* arg, const bool reserved)
+{
+    if(handle == NULL)
+        return false;
+    
+    // Interrupts of the same priority level never preempt each other, so each queue has exactly one producer at a time
+    struct PostQueue* queue = &postQueues[cp0StatusIpl(_CP0_GET_STATUS())];
+    size_t head = queue->head;
+    if(head - queue->tail >= POST_QUEUE_SIZE - (reserved ? 0 : queue->reserved))
+        return false; // Queue is full, unreserved posts never take the reserved slots
+    
+    queue->slots[head & (POST_QUEUE_SIZE - 1)].handle = handle;
+    queue->slots[head & (POST_QUEUE_SIZE - 1)].arg = arg;
+    queue->head = head + 1; // Publish only after the slot is filled
+    return true;
+}
+
+bool post_take(struct PostedWork* work)
+{
+    size_t i = POST_IPL_COUNT;
+    
+    // Highest interrupt priority level first
+    while(i-- > 0) {
+        struct PostQueue* queue = &postQueues[i];
+        size_t tail = queue->tail;
+        if(tail != queue->head) {
+            *work = queue->slots[tail & (POST_QUEUE_SIZE - 1)];
+            queue->tail = tail + 1; // Release the slot only after it is copied
+            return true;
         }
     }
+    return false;
 }
 
-struct RobinTask* find_robin_task(unsigned int identifier)
+#ifdef SCHEDULER_TICKLESS_IDLE
+bool post_pending()
 {
-    struct RobinTask* robinTask = NULL;
     size_t i;
-    for(i = 0; i < nRobinTasks; ++i) {
-        if(robinTaskPool[i].identifier == identifier) {
-            robinTask = &robinTaskPool[i];
-            break;
-        }
+    for(i = 0; i < POST_IPL_COUNT; ++i) {
+        if(postQueues[i].tail != postQueues[i].head)
+            return true;
     }
-    return robinTask;
+    return false;
+}
+#endif
+
+SchedulerTicks current_ticks()
+{
+    return systemTicks + ((HW_TIMER - lastTickCount) & HW_TIMER_MASK);
+}
+
+#ifdef SCHEDULER_PROFILING
+void profile_reset(struct SchedulerProfile* profile)
+{
+    profile->calls = 0;
+    profile->minCycles = ULONG_MAX;
+    profile->maxCycles = 0;
+    profile->totalCycles = 0;
+    profile->maxLateness = 0;
+    profile->totalLateness = 0;
+}
+
+void profile_record(struct SchedulerProfile* profile, const unsigned long cycles)
+{
+    profile->calls++;
+    profile->totalCycles += cycles;
+    if(cycles < profile->minCycles)
+        profile->minCycles = cycles;
+    if(cycles > profile->maxCycles)
+        profile->maxCycles = cycles;
+}
+
+void profile_lateness(struct Event* event)
+{
+    // Budgeted dispatch may run well after the start of the pass, so use the current time
+    SchedulerTicks now = current_ticks();
+    SchedulerTicks lateness = isDue(event->release, now) ? (now - event->release) : 0;
+    
+    event->profile.totalLateness += lateness;
+    if(lateness > event->profile.maxLateness)
+        event->profile.maxLateness = lateness;
+}
+
+void profile_print(const char* type, const SchedulerId id, const struct SchedulerProfile* profile)
+{
+    unsigned long calls = (profile->calls > 0) ? profile->calls : 1; // Prevent a division by zero
+    
+    // Printed as the identifier handed out on creation, so rows can be matched against the application
+    print_f("%s:%08x\t%d\t%d\t%d\t%d\t%d\t%d\r\n", type, id, profile->calls,
+            (profile->calls > 0) ? profile->minCycles : 0,
+            (unsigned long)(profile->totalCycles / calls),
+            profile->maxCycles,
+            (unsigned long)(((profile->totalLateness / calls) * 1000000LU) / SYSTEM_TICK_FREQUENCY),
+            (unsigned long)((profile->maxLateness * 1000000LU) / SYSTEM_TICK_FREQUENCY));
+}
+#endif
+
+struct Event* find_event(const SchedulerId id)
+{
+    struct Event* event = NULL;
+    size_t index = idIndex(id);
+    
+    if(index < nEvents && eventPool[index].opt.assigned && eventPool[index].generation == idGeneration(id))
+        event = &eventPool[index];
+    return event;
+}
+
+void unlink_event(struct Event* event)
+{
+    // Suspended events are neither pending nor ready
+    if(event->opt.suspended)
+        return;
+    
+    if(event->opt.ready)
+        ready_remove(event);
+    else
+        heap_remove(event);
+}
+
+struct RobinTask* find_robin_task(const SchedulerId id)
+{
+    struct RobinTask* task = NULL;
+    size_t index = idIndex(id);
+    
+    if(index < nRobinTasks && robinTaskPool[index].opt.assigned && robinTaskPool[index].generation == idGeneration(id))
+        task = &robinTaskPool[index];
+    return task;
+}
+
+void robin_list_push(struct RobinTask* task)
+{
+    task->listIndex = nActiveRobinTasks;
+    robinTaskList[nActiveRobinTasks++] = task;
+}
+
+void robin_list_remove(struct RobinTask* task)
+{
+    // Fill the gap with the last task, the round-robin order is not guaranteed anyway
+    struct RobinTask* last = robinTaskList[--nActiveRobinTasks];
+    robinTaskList[task->listIndex] = last;
+    last->listIndex = task->listIndex;
 }
\ No newline at end of file
@@ -1,15 +1,32 @@
 #ifndef SCHEDULER_H
 #define SCHEDULER_H
 
+#include "cfg/scheduler_config.h"
 #include "../../lib/std/stdtypes.h"
 
 #define PRIO_HIGH   0
 #define PRIO_NORMAL 1
 #define PRIO_LOW    2
 
-struct Event;
-struct RobinTask;
+#define SCHEDULER_POLICY_PRIORITY   0 // Ready events are executed on their fixed priority
+#define SCHEDULER_POLICY_EDF        1 // Ready events are executed on their absolute deadline, earliest first
+#define SCHEDULER_POLICY_RM         2 // Ready events are executed on their interval, shortest first
+
+#define SCHEDULER_ID_INVALID    0
+#define SCHEDULER_PHASE_AUTO    0xFFFFFFFFLU // Let the scheduler pick the phase that collides least with the existing events
+
+#ifdef SCHEDULER_LOAD_METER
+    #define SCHEDULER_ISR_ENTER()   scheduler_isr_enter() // Place at the start of an interrupt service routine to account its time
+    #define SCHEDULER_ISR_EXIT()    scheduler_isr_exit()  // Place at the end of an interrupt service routine, before any return
+#else
+    #define SCHEDULER_ISR_ENTER()
+    #define SCHEDULER_ISR_EXIT()
+#endif
+
+typedef unsigned long SchedulerId; // Generation checked identifier of an event or robin task
 typedef void (*SchedulerHandle)();
+typedef void (*SchedulerPostHandle)(void* arg);
+typedef unsigned long long SchedulerTicks;
 
 enum SchedulerIntervalUnit {
     SCHEDULER_UNIT_US = 0,
@@ -17,6 +34,29 @@ enum SchedulerIntervalUnit {
     SCHEDULER_UNIT_S
 };
 
+enum SchedulerLoad {
+    SCHEDULER_LOAD_EVENTS = 0,  // Event handles, including the static event table
+    SCHEDULER_LOAD_DEFERRED,    // Work posted from interrupts
+    SCHEDULER_LOAD_ROBIN,       // Robin tasks
+    SCHEDULER_LOAD_ISR,         // Interrupts enclosed by SCHEDULER_ISR_ENTER and SCHEDULER_ISR_EXIT
+    SCHEDULER_LOAD_IDLE,        // Idle mode and passes without anything to execute
+    SCHEDULER_LOAD_OVERHEAD,    // Scheduler bookkeeping and the remainder of the main loop
+    SCHEDULER_LOAD_COUNT
+};
+
+enum SchedulerLoadWindow {
+    SCHEDULER_WINDOW_100MS = 0,
+    SCHEDULER_WINDOW_1S,
+    SCHEDULER_WINDOW_10S,
+    SCHEDULER_WINDOW_COUNT
+};
+
+enum SchedulerCatchUp {
+    SCHEDULER_CATCH_UP_SKIP = 0,    // Missed periods are dropped, the event stays aligned to its original release times
+    SCHEDULER_CATCH_UP_BURST,       // Missed periods are executed back-to-back until the event is back on schedule
+    SCHEDULER_CATCH_UP_COALESCE     // Missed periods are merged into a single execution, see scheduler_coalesced_periods()
+};
+
 /**
  * Initialization of the scheduler
  * @return Returns 'true' on success, otherwise 'false'
@@ -26,35 +66,239 @@ bool scheduler_init();
 
 /**
  * Execution of the scheduler
+ * @note Only a single ready event is executed per call, unless SCHEDULER_DISPATCH_BUDGET_US is defined. In that case all ready events are executed in priority order until the budget is spent
+ * @note With SCHEDULER_TICKLESS_IDLE defined the core enters idle mode until the next release when there is nothing to execute
  */
 void scheduler_execute();
 
 /**
  * Adds an event to the scheduler with a given interval time and priority
  * @param handle A handle that will be executed at the given interval
- * @param interval Interval in microseconds this event should be executed
+ * @param interval Interval this event should be executed at
+ * @param unit The time unit of the interval
  * @param priority The priority of the event
- * @return Returns a pointer to the created event
+ * @return Returns the identifier of the created event, or 'SCHEDULER_ID_INVALID' when the pool is exhausted
+ * @note The event is released on the next pass, or with an automatically picked phase when SCHEDULER_PHASE_SPREADING is defined
  */
-struct Event* scheduler_create_event(const SchedulerHandle handle, const unsigned short interval, const enum SchedulerIntervalUnit unit, const unsigned char priority);
+SchedulerId scheduler_create_event(const SchedulerHandle handle, const unsigned long interval, const enum SchedulerIntervalUnit unit, const unsigned char priority);
+
+/**
+ * Adds an event to the scheduler with a given interval time, phase offset and priority
+ * @param handle A handle that will be executed at the given interval
+ * @param interval Interval this event should be executed at
+ * @param phase Delay of the first release, in the same unit as the interval, or 'SCHEDULER_PHASE_AUTO'
+ * @param unit The time unit of the interval and phase
+ * @param priority The priority of the event
+ * @return Returns the identifier of the created event, or 'SCHEDULER_ID_INVALID' when the pool is exhausted
+ * @note Events with the same or harmonic intervals keep their relative phase, offsetting them keeps their releases from stacking up on a single pass
+ */
+SchedulerId scheduler_create_event_phased(const SchedulerHandle handle, const unsigned long interval, const unsigned long phase, const enum SchedulerIntervalUnit unit, const unsigned char priority);
 
 /**
  * Removes an event from the scheduler, freeing up one place in the pool
- * @param event The event to be removed
+ * @param id The event to be removed
+ * @note The identifier, and every copy of it, becomes invalid and is ignored by all functions from here on
+ */
+void scheduler_remove_event(const SchedulerId id);
+
+/**
+ * Suspends an event, it will not be executed until it is resumed
+ * @param id The event to be suspended
+ */
+void scheduler_suspend_event(const SchedulerId id);
+
+/**
+ * Resumes a suspended event, it will expire on the next pass
+ * @param id The event to be resumed
+ */
+void scheduler_resume_event(const SchedulerId id);
+
+/**
+ * Sets the policy to apply when an event was dispatched too late to meet one or more of its deadlines
+ * @param id The event to be changed
+ * @param catchUp The catch-up policy, defaults to 'SCHEDULER_CATCH_UP_SKIP'
+ * @note Releases are absolute, the next release is always the previous release plus the interval
+ */
+void scheduler_set_catch_up(const SchedulerId id, const enum SchedulerCatchUp catchUp);
+
+/**
+ * Sets the deadline of an event relative to each release
+ * @param id The event to be changed
+ * @param deadline The relative deadline, defaults to the interval
+ * @param unit The time unit of the deadline
+ * @note The deadline orders ready events under SCHEDULER_POLICY_EDF and is used for the deadline miss accounting under every policy
+ */
+void scheduler_set_deadline(const SchedulerId id, const unsigned long deadline, const enum SchedulerIntervalUnit unit);
+
+/**
+ * Gets the number of executions that completed after their absolute deadline
+ * @param id The event to get the count from
+ * @return Returns the number of deadline misses
+ * @note Periods that were skipped entirely are counted by scheduler_missed_periods() instead
+ */
+unsigned long scheduler_deadline_misses(const SchedulerId id);
+
+/**
+ * Gets the number of periods an event has missed since it was created
+ * @param id The event to get the count from
+ * @return Returns the number of missed periods
+ */
+unsigned long scheduler_missed_periods(const SchedulerId id);
+
+/**
+ * Gets the number of minor frames of the cyclic executive that were skipped because they had passed before they could be executed
+ * @return Returns the number of frame overruns, always '0' unless SCHEDULER_CYCLIC_EXECUTIVE is defined
+ */
+unsigned long scheduler_frame_overruns();
+
+/**
+ * Gets the number of periods covered by the event that is currently being executed
+ * @return Returns '1' for an on-time execution, or more when periods were coalesced
+ * @note Only meaningful when called from within an event handle
+ */
+unsigned long scheduler_coalesced_periods();
+
+/**
+ * Gets the monotonic system tick count of the scheduler
+ * @return Returns the system tick count sampled at the start of the current scheduler pass
+ * @note The hardware timer is extended to 64 bit in software, the count will therefore never wrap
+ */
+SchedulerTicks scheduler_get_ticks();
+
+/**
+ * Posts deferred work to the scheduler, the handle is executed once from the main loop
+ * @param handle The handle to execute
+ * @param arg The argument passed to the handle
+ * @return Returns 'true' on success, or 'false' when the post queue of the current interrupt priority level is full
+ * @note Safe to call from any interrupt, posted work is executed before robin tasks and from the highest posting priority level first
+ */
+bool scheduler_post(const SchedulerPostHandle handle, void* arg);
+
+/**
+ * Reserves a slot in the post queue of an interrupt priority level, which scheduler_post() leaves free
+ * @param priority The interrupt priority level that posts through scheduler_post_reserved(), '0' for the main loop
+ * @return Returns 'true' on success, or 'false' when the level is invalid or no unreserved slot would be left
+ * @note Reservations are cleared by scheduler_init(), so call this from the init function of the posting module
+ */
+bool scheduler_reserve_post(const unsigned char priority);
+
+/**
+ * Posts deferred work into a slot reserved by scheduler_reserve_post()
+ * @param handle The handle to execute
+ * @param arg The argument passed to the handle
+ * @return Returns 'true' on success, which is guaranteed while each reservation has at most one post outstanding
+ * @note Safe to call from any interrupt, the guarantee only holds at a reserved priority level
+ */
+bool scheduler_post_reserved(const SchedulerPostHandle handle, void* arg);
+
+/**
+ * Prints the execution profile of all events and robin tasks as a table, rows are labeled E or R followed by the identifier in hexadecimal
+ * @note Only available when SCHEDULER_PROFILING is defined, otherwise nothing is printed. Execution times are in core timer cycles
+ */
+void scheduler_print_profile();
+
+/**
+ * Gets the share of time the scheduler spent idle since the previous call
+ * @return Returns the idle time in percent, ranging from 0 to 100
+ * @note Always '0' unless SCHEDULER_TICKLESS_IDLE is defined, each call starts a new measurement window
+ */
+unsigned char scheduler_idle_percentage();
+
+/**
+ * Gets the exponentially averaged share of core time spent on a kind of load
+ * @param load The kind of load
+ * @param window The averaging window
+ * @return Returns the load in tenths of a percent, ranging from 0 to 1000
+ * @note Always '0' unless SCHEDULER_LOAD_METER is defined
+ */
+unsigned short scheduler_load(const enum SchedulerLoad load, const enum SchedulerLoadWindow window);
+
+/**
+ * Prints the load of each kind over all averaging windows as a table
+ * @note Only available when SCHEDULER_LOAD_METER is defined, otherwise nothing is printed
+ */
+void scheduler_print_load();
+
+/**
+ * Marks the entry of an interrupt service routine for the load meter, use SCHEDULER_ISR_ENTER instead
+ */
+void scheduler_isr_enter();
+
+/**
+ * Marks the exit of an interrupt service routine for the load meter, use SCHEDULER_ISR_EXIT instead
+ */
+void scheduler_isr_exit();
+
+/**
+ * Converts a time to system ticks
+ * @param time The time to convert
+ * @param unit The time unit
+ * @return Returns the time in system ticks
  */
-void scheduler_remove_event(struct Event* event);
+SchedulerTicks scheduler_calc_ticks(const unsigned long time, const enum SchedulerIntervalUnit unit);
 
 /**
  * Adds an robin task to the scheduler
  * @param handle A handle that will be executed at the given interval
- * @return Returns a pointer to the created robin task
+ * @return Returns the identifier of the created robin task, or 'SCHEDULER_ID_INVALID' when the pool is exhausted
  */
-struct RobinTask* scheduler_create_robin_task(const SchedulerHandle handle);
+SchedulerId scheduler_create_robin_task(const SchedulerHandle handle);
 
 /**
  * Removes a robin task from the scheduler, freeing up one place in the pool
- * @param task The robin task to be removed
+ * @param id The robin task to be removed
+ * @note The identifier, and every copy of it, becomes invalid and is ignored by all functions from here on
+ */
+void scheduler_remove_robin_task(const SchedulerId id);
+
+/**
+ * Suspends a robin task, it will not be executed until it is resumed
+ * @param id The robin task to be suspended
+ */
+void scheduler_suspend_robin_task(const SchedulerId id);
+
+/**
+ * Resumes a suspended robin task
+ * @param id The robin task to be resumed
+ */
+void scheduler_resume_robin_task(const SchedulerId id);
+
+/**
+ * Sets the weight of a robin task, each round it receives its weight times SCHEDULER_ROBIN_QUANTUM_US of core time
+ * @param id The robin task
+ * @param weight The weight, ranging from 1 to 255, defaults to 1
+ * @note Only used when SCHEDULER_ROBIN_QUANTUM_US is defined, otherwise every robin task runs once per round
+ */
+void scheduler_set_robin_weight(const SchedulerId id, const unsigned char weight);
+
+/**
+ * Sets the execution time a single call of a robin task may take
+ * @param id The robin task
+ * @param budget The budget, '0' for unlimited which is the default
+ * @param unit The time unit of the budget
+ * @note A call exceeding the budget is counted as an overrun and demotes the task, halving its weight up to three times.
+ * Each round without an overrun restores one level
+ */
+void scheduler_set_robin_budget(const SchedulerId id, const unsigned long budget, const enum SchedulerIntervalUnit unit);
+
+/**
+ * Gets the number of calls of a robin task that exceeded its budget
+ * @param id The robin task
+ * @return Returns the number of overruns, always '0' unless SCHEDULER_ROBIN_QUANTUM_US is defined
+ */
+unsigned long scheduler_robin_overruns(const SchedulerId id);
+
+/**
+ * Gets the share of the robin task core time that was delivered to a robin task
+ * @param id The robin task
+ * @return Returns the share in permille, always '0' unless SCHEDULER_ROBIN_QUANTUM_US is defined
+ */
+unsigned short scheduler_robin_share(const SchedulerId id);
+
+/**
+ * Prints the weight, demotion, delivered share and overruns of all robin tasks as a table
+ * @note Only available when SCHEDULER_ROBIN_QUANTUM_US is defined, otherwise nothing is printed
  */
-void scheduler_remove_robin_task(struct RobinTask* task);
+void scheduler_print_robin_shares();
 
 #endif /* SCHEDULER_H */
\ No newline at end of file
@@ -0,0 +1,251 @@
+#include "alarm.h"
+#include "../../scheduler/scheduler.h"
+#include "../../../peripheral/interrupt/interrupt.h"
+#include "../../../lib/print/assert.h"
+#include <xc.h>
+#include <stddef.h>
+
+#define ALARM_POOL_SIZE_DEFAULT     8
+#define ALARM_POOL_MAX              32
+
+struct Alarm
+{
+    AlarmHandle handle;
+    void* context; // Passed to the handle
+    unsigned long expires; // Next time the alarm goes off, in seconds since 2000-01-01 00:00:00
+    unsigned long timeOfDay; // Seconds since midnight of a daily alarm
+    struct Alarm* next; // Next alarm in the free list
+    unsigned char weekdays; // Weekday mask of a daily alarm
+    struct {
+        unsigned char assigned  :1;
+        unsigned char pending   :1;
+        unsigned char daily     :1;
+        unsigned char reserved  :5;
+    } opt;
+};
+
+static unsigned long alarm_next_daily(const struct Alarm* alarm, const unsigned long after);
+static void alarm_update();
+static bool alarm_program();
+static void alarm_interrupt();
+static void alarm_post();
+static void alarm_deferred(void* arg);
+
+#ifdef ALARM_POOL_SIZE
+    #if (ALARM_POOL_SIZE < 1)
+        #error "Alarm pool size must be a non negative integer with a minimum of 1"
+    #elif (ALARM_POOL_SIZE > ALARM_POOL_MAX)
+        #error "Maximum number of alarms is exceeded, increase maximum or lower the pool size."
+    #else
+        static struct Alarm alarmPool[ALARM_POOL_SIZE];
+        static const size_t nAlarms = ALARM_POOL_SIZE;
+    #endif
+#else
+    static struct Alarm alarmPool[ALARM_POOL_SIZE_DEFAULT];
+    static const size_t nAlarms = ALARM_POOL_SIZE_DEFAULT;
+#endif
+
+static struct Alarm* freeAlarms = NULL;
+static volatile bool deferredPosted = false; // At most one post is outstanding, so the reserved slots always suffice
+
+bool alarm_init()
+{
+    // Invalidate all alarms and chain them into the free list
+    size_t i;
+    freeAlarms = NULL;
+    for(i = nAlarms; i > 0; --i) {
+        alarmPool[i - 1].opt.assigned = 0;
+        alarmPool[i - 1].opt.pending = 0;
+        alarmPool[i - 1].next = freeAlarms;
+        freeAlarms = &alarmPool[i - 1];
+    }
+    rtcc_cancel_alarm();
+    deferredPosted = false;
+    
+    // Posts come from the main loop and from the RTCC interrupt, a reserved slot keeps them from being dropped
+    return scheduler_reserve_post(0) && scheduler_reserve_post(RTCC_INTERRUPT_PRIORITY);
+}
+
+struct Alarm* alarm_create(const AlarmHandle handle, void* context)
+{
+    struct Alarm* alarm = freeAlarms;
+    
+    if(handle == NULL || alarm == NULL)
+        return NULL;
+    
+    freeAlarms = alarm->next;
+    alarm->handle = handle;
+    alarm->context = context;
+    alarm->expires = 0;
+    alarm->timeOfDay = 0;
+    alarm->next = NULL;
+    alarm->weekdays = 0;
+    alarm->opt.pending = 0;
+    alarm->opt.daily = 0;
+    alarm->opt.assigned = 1;
+    return alarm;
+}
+
+void alarm_invalidate(struct Alarm* alarm)
+{
+    ASSERT(alarm != NULL);
+    
+    if(!alarm->opt.assigned)
+        return;
+    
+    alarm_stop(alarm);
+    alarm->opt.assigned = 0;
+    alarm->next = freeAlarms;
+    freeAlarms = alarm;
+}
+
+bool alarm_start_daily(struct Alarm* alarm, const unsigned char hour, const unsigned char minute, const unsigned char second, const unsigned char weekdays)
+{
+    ASSERT(alarm != NULL);
+    
+    if(hour > 23 || minute > 59 || second > 59 || (weekdays & ALARM_EVERY_DAY) == 0)
+        return false;
+    
+    alarm->timeOfDay = hour * 3600LU + minute * 60LU + second;
+    alarm->weekdays = weekdays & ALARM_EVERY_DAY;
+    alarm->expires = alarm_next_daily(alarm, rtcc_get_seconds());
+    alarm->opt.daily = 1;
+    alarm->opt.pending = 1;
+    alarm_update();
+    return true;
+}
+
+bool alarm_start_once(struct Alarm* alarm, const struct RtccTime* time)
+{
+    ASSERT(alarm != NULL && time != NULL);
+    
+    const unsigned long expires = rtcc_to_seconds(time);
+    if(expires <= rtcc_get_seconds())
+        return false;
+    
+    alarm->expires = expires;
+    alarm->opt.daily = 0;
+    alarm->opt.pending = 1;
+    alarm_update();
+    return true;
+}
+
+void alarm_stop(struct Alarm* alarm)
+{
+    ASSERT(alarm != NULL);
+    
+    if(!alarm->opt.pending)
+        return;
+    
+    alarm->opt.pending = 0;
+    alarm_update();
+}
+
+unsigned char alarm_is_pending(const struct Alarm* alarm)
+{
+    ASSERT(alarm != NULL);
+    
+    return alarm->opt.pending;
+}
+
+bool alarm_set_clock(const struct RtccTime* time)
+{
+    size_t i;
+    
+    if(!rtcc_set_time(time))
+        return false;
+    
+    const unsigned long now = rtcc_get_seconds();
+    for(i = 0; i < nAlarms; ++i) {
+        if(alarmPool[i].opt.pending && alarmPool[i].opt.daily)
+            alarmPool[i].expires = alarm_next_daily(&alarmPool[i], now);
+    }
+    alarm_update();
+    return true;
+}
+
+unsigned long alarm_next_daily(const struct Alarm* alarm, const unsigned long after)
+{
+    unsigned long day = after / RTCC_SECONDS_PER_DAY;
+    unsigned long expires;
+    size_t i;
+    
+    // The mask holds at least a single weekday, so one of the coming eight days matches
+    for(i = 0; i <= RTCC_WEEKDAY_COUNT; ++i, ++day) {
+        expires = day * RTCC_SECONDS_PER_DAY + alarm->timeOfDay;
+        if(expires > after && (alarm->weekdays & ALARM_DAY((day + RTCC_EPOCH_WEEKDAY) % RTCC_WEEKDAY_COUNT)))
+            break;
+    }
+    return expires;
+}
+
+void alarm_update()
+{
+    if(alarm_program())
+        alarm_post(); // Already due, executed from the main loop as well
+}
+
+bool alarm_program()
+{
+    struct Alarm* earliest = NULL;
+    size_t i;
+    
+    for(i = 0; i < nAlarms; ++i) {
+        if(alarmPool[i].opt.pending && (earliest == NULL || alarmPool[i].expires < earliest->expires))
+            earliest = &alarmPool[i];
+    }
+    
+    rtcc_cancel_alarm();
+    if(earliest == NULL)
+        return false;
+    
+    // The RTCC alarm reaches a year ahead at most, a later alarm is re-armed when the intermediate one goes off
+    const unsigned long now = rtcc_get_seconds();
+    unsigned long expires = earliest->expires;
+    if(expires > now && expires - now > RTCC_ALARM_MAX_AHEAD)
+        expires = now + RTCC_ALARM_MAX_AHEAD;
+    
+    if(!rtcc_set_alarm(expires, alarm_interrupt))
+        return true; // Passed already
+    if(rtcc_get_seconds() >= expires) {
+        rtcc_cancel_alarm(); // Passed while arming, the alarm may not have matched
+        return true;
+    }
+    return false;
+}
+
+void alarm_interrupt()
+{
+    alarm_post();
+}
+
+void alarm_post()
+{
+    // The flag is shared with the RTCC interrupt, and alarm_deferred() re-arms the RTCC once the post is executed
+    const unsigned long status = __builtin_disable_interrupts();
+    if(!deferredPosted)
+        deferredPosted = scheduler_post_reserved(alarm_deferred, NULL);
+    _CP0_SET_STATUS(status);
+}
+
+void alarm_deferred(void* arg)
+{
+    unsigned long now;
+    size_t i;
+    
+    deferredPosted = false; // Cleared first, alarms that go off from here on are posted again
+    do {
+        now = rtcc_get_seconds();
+        for(i = 0; i < nAlarms; ++i) {
+            struct Alarm* alarm = &alarmPool[i];
+            if(!alarm->opt.pending || alarm->expires > now)
+                continue;
+            
+            if(alarm->opt.daily)
+                alarm->expires = alarm_next_daily(alarm, now);
+            else
+                alarm->opt.pending = 0;
+            (*alarm->handle)(alarm, alarm->context);
+        }
+    } while(alarm_program());
+}
@@ -0,0 +1,86 @@
+#ifndef ALARM_H
+#define	ALARM_H
+
+#include "../../../peripheral/rtcc/rtcc.h"
+#include "../../../lib/std/stdtypes.h"
+
+#define ALARM_POOL_SIZE         8
+
+#define ALARM_DAY(weekday)      (1 << (weekday)) // Weekday mask of a single RtccWeekday
+#define ALARM_EVERY_DAY         0x7F
+#define ALARM_WORKDAYS          0x3E // Monday up to Friday
+#define ALARM_WEEKEND           0x41 // Saturday and Sunday
+
+/*
+ * Wall-clock alarms on the RTCC, e.g. starting a playlist at 09:00 on workdays and blanking the cube at 22:00.
+ * The RTCC alarm is armed for the earliest pending alarm, its interrupt wakes the processor and posts the handles
+ * to the scheduler. Handles are therefore executed from the main loop, nothing is polled meanwhile.
+ */
+
+struct Alarm;
+
+typedef void (*AlarmHandle)(struct Alarm* alarm, void* context);
+
+/**
+ * Initializes the alarm pool
+ * @return Returns 'true' on success, otherwise 'false'
+ * @note This function will invalidate the alarm pool, meaning no alarm should be created before this function is called.
+ *       The RTCC and the scheduler must be initialized before, a post slot is reserved for the main loop and the RTCC interrupt.
+ */
+bool alarm_init();
+
+/**
+ * Claims an alarm from the pool
+ * @param handle The handle that is executed each time the alarm goes off
+ * @param context User data passed to the handle together with the alarm
+ * @return Returns a pointer to the created alarm or 'NULL' when the pool is exhausted
+ */
+struct Alarm* alarm_create(const AlarmHandle handle, void* context);
+
+/**
+ * Stops an alarm and returns it to the pool
+ * @param alarm The alarm to be invalidated
+ */
+void alarm_invalidate(struct Alarm* alarm);
+
+/**
+ * Starts an alarm that goes off at a time of day, repeated on the selected weekdays
+ * @param alarm The alarm to start
+ * @param hour The hour, 0 up to 23
+ * @param minute The minute, 0 up to 59
+ * @param second The second, 0 up to 59
+ * @param weekdays Mask of the weekdays on which the alarm goes off, e.g. ALARM_WORKDAYS or ALARM_DAY(RTCC_MONDAY)
+ * @return Returns 'true' on success, or 'false' when the time or the mask is invalid
+ */
+bool alarm_start_daily(struct Alarm* alarm, const unsigned char hour, const unsigned char minute, const unsigned char second, const unsigned char weekdays);
+
+/**
+ * Starts an alarm that goes off once at a given date and time
+ * @param alarm The alarm to start
+ * @param time The date and time of the alarm, the weekday is ignored
+ * @return Returns 'true' on success, or 'false' when the time has already passed
+ */
+bool alarm_start_once(struct Alarm* alarm, const struct RtccTime* time);
+
+/**
+ * Stops an alarm, its handle will not be executed
+ * @param alarm The alarm to stop
+ */
+void alarm_stop(struct Alarm* alarm);
+
+/**
+ * Checks if an alarm is pending
+ * @param alarm The alarm to be checked
+ * @return Returns '1' if the alarm is pending otherwise '0'
+ */
+unsigned char alarm_is_pending(const struct Alarm* alarm);
+
+/**
+ * Sets the wall-clock time and reschedules the pending alarms
+ * @param time The new time and date
+ * @return Returns 'true' on success, or 'false' when the time or date is invalid
+ * @note Daily alarms skipped by moving the clock forward do not go off, once alarms that have passed go off immediately
+ */
+bool alarm_set_clock(const struct RtccTime* time);
+
+#endif	/* ALARM_H */
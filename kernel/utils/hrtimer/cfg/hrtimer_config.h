@@ -0,0 +1,24 @@
+#ifndef HRTIMER_CONFIG_H
+#define HRTIMER_CONFIG_H
+
+//#define HRTIMER_ENABLED             // Initialize the high resolution timers from main, which claims the timer pair TMR2/TMR3 and OC1 or the custom timer below
+#define HRTIMER_POOL_SIZE           8
+#define HRTIMER_INTERRUPT_PRIORITY  INTERRUPT_PRIORITY_6    // Handles are executed at this priority, keep it below the peripheral interrupts that must not be delayed
+#define HRTIMER_INTERRUPT_IPL       IPL6AUTO                // Must match the interrupt priority
+#define HRTIMER_MIN_TICKS           8                       // Deadlines closer than this are postponed, so the compare is never programmed behind the count
+
+//#define HRTIMER_CUSTOM_TIMER        // Indicates custom hardware timer settings should be used
+//#define HR_TMR_REG          TMR2    // Hardware timer, must be a 32 bit timer pair, it runs free and is never written
+//#define HR_TMR_PR_REG       PR2     // Hardware timer period register
+//#define HR_TMR_CFG_REG      T2CON   // Hardware timer configuration register
+//#define HR_TMR_CFG_WORD     0x0038  // Hardware timer configuration word, timer off
+//#define HR_TMR_PRESCALER    8       // Hardware timer prescaler
+//#define HR_TMR_CFG_EN_BIT   15      // Hardware timer enable bit of the configuration word
+//#define HR_OC_REG           OC1R    // Output compare register, compared against the 32 bit count of the timer pair
+//#define HR_OC_CFG_REG       OC1CON  // Output compare configuration register
+//#define HR_OC_CFG_WORD      0x0023  // Output compare configuration word, module off, 32 bit toggle mode on the timer pair
+//#define HR_OC_CFG_EN_BIT    15      // Output compare enable bit of the configuration word
+//#define HR_OC_INTERRUPT     INTERRUPT_OUTPUT_COMPARE1   // Interrupt of the output compare
+//#define HR_OC_VECTOR        _OUTPUT_COMPARE_1_VECTOR    // Interrupt vector of the output compare
+
+#endif /* HRTIMER_CONFIG_H */
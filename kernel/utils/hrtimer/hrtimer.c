@@ -0,0 +1,276 @@
+#include "hrtimer.h"
+#include "cfg/hrtimer_config.h"
+#include "../../scheduler/scheduler.h"
+#include "../../../peripheral/interrupt/interrupt.h"
+#include "../../../lib/print/assert.h"
+#include <xc.h>
+#include <sys/attribs.h>
+#include <stddef.h>
+
+#define HRTIMER_POOL_SIZE_DEFAULT   8
+#define HRTIMER_POOL_MAX            64
+#define HRTIMER_FREE_RUNNING        0xFFFFFFFFLU // Period of the hardware timer, it wraps over its full width and is never reset
+
+#define isDue(deadline, now)        ((long)((now) - (deadline)) >= 0) // The 32 bit count wraps, delays must stay below 2^31 ticks
+
+#ifdef HRTIMER_CUSTOM_TIMER
+    #define HR_TIMER                HR_TMR_REG
+    #define HR_TIMER_PR_REG         HR_TMR_PR_REG
+    #define HR_TIMER_CFG_REG        HR_TMR_CFG_REG
+    #define HR_TIMER_CFG_WORD       HR_TMR_CFG_WORD
+    #define HR_TIMER_PRESCALER      HR_TMR_PRESCALER
+    #define HR_TIMER_CFG_EN_BIT     HR_TMR_CFG_EN_BIT
+    #define HR_COMPARE_REG          HR_OC_REG
+    #define HR_COMPARE_CFG_REG      HR_OC_CFG_REG
+    #define HR_COMPARE_CFG_WORD     HR_OC_CFG_WORD
+    #define HR_COMPARE_CFG_EN_BIT   HR_OC_CFG_EN_BIT
+    #define HR_COMPARE_INTERRUPT    HR_OC_INTERRUPT
+    #define HR_COMPARE_VECTOR       HR_OC_VECTOR
+#elif defined(_TMR2) && defined(_TMR3) && defined(_OCMP1)
+    #define HR_TIMER                TMR2 // TMR2 and TMR3 cascaded into a single 32 bit timer
+    #define HR_TIMER_PR_REG         PR2
+    #define HR_TIMER_CFG_REG        T2CON
+    #define HR_TIMER_CFG_WORD       0x0038 // Timer off; 1:8 prescaler; 32 bit mode
+    #define HR_TIMER_PRESCALER      8
+    #define HR_TIMER_CFG_EN_BIT     15
+    #define HR_COMPARE_REG          OC1R
+    #define HR_COMPARE_CFG_REG      OC1CON
+    #define HR_COMPARE_CFG_WORD     0x0023 // Module off; 32 bit compare on the TMR2/3 pair; toggle mode, so every match interrupts. The output reaches no pin unless it is mapped
+    #define HR_COMPARE_CFG_EN_BIT   15
+    #define HR_COMPARE_INTERRUPT    INTERRUPT_OUTPUT_COMPARE1
+    #define HR_COMPARE_VECTOR       _OUTPUT_COMPARE_1_VECTOR
+#else
+    #error "No hardware timer available for the high resolution timers, please define a custom timer in hrtimer_config.h"
+#endif
+
+#if defined(_SYS_CLK) && defined(_PB_DIV)
+    #define HR_TICK_FREQUENCY ((_SYS_CLK / _PB_DIV) / HR_TIMER_PRESCALER)
+#elif defined(PBCLK_FREQUENCY)
+    #define HR_TICK_FREQUENCY (PBCLK_FREQUENCY / HR_TIMER_PRESCALER)
+#else
+    #error "Timer tick could not be calculated, please define the PBCLK_FREQUENCY in scheduler_config.h or _SYS_CLK and _PB_DIV globally."
+#endif
+
+#define hrTicks(us)                 ((unsigned long)(((unsigned long long)(us) * HR_TICK_FREQUENCY) / 1000000LU))
+
+struct HrTimer
+{
+    HrTimerHandle handle;
+    void* context; // Passed to the handle
+    unsigned long deadline; // Count of the hardware timer
+    struct HrTimer* next; // Next timer in the pending queue, or in the free list when unassigned
+    struct {
+        unsigned char assigned  :1;
+        unsigned char pending   :1;
+        unsigned char reserved  :6;
+    } opt;
+};
+
+static void hrtimer_program();
+static void hrtimer_schedule(struct HrTimer* timer, const unsigned long deadline);
+static void queue_insert(struct HrTimer* timer);
+static bool queue_remove(struct HrTimer* timer);
+
+#ifdef HRTIMER_POOL_SIZE
+    #if (HRTIMER_POOL_SIZE < 1)
+        #error "High resolution timer pool size must be a non negative integer with a minimum of 1"
+    #elif (HRTIMER_POOL_SIZE > HRTIMER_POOL_MAX)
+        #error "Maximum number of high resolution timers is exceeded, increase maximum or lower the pool size."
+    #else
+        static struct HrTimer timerPool[HRTIMER_POOL_SIZE];
+        static const size_t nTimers = HRTIMER_POOL_SIZE;
+    #endif
+#else
+    static struct HrTimer timerPool[HRTIMER_POOL_SIZE_DEFAULT];
+    static const size_t nTimers = HRTIMER_POOL_SIZE_DEFAULT;
+#endif
+
+static struct HrTimer* freeTimers = NULL;
+static struct HrTimer* pendingHead = NULL; // Sorted on deadline, earliest first
+
+bool hrtimer_init()
+{
+    // Invalidate all timers and chain them into the free list
+    size_t i;
+    freeTimers = NULL;
+    for(i = nTimers; i > 0; --i) {
+        timerPool[i - 1].opt.assigned = 0;
+        timerPool[i - 1].opt.pending = 0;
+        timerPool[i - 1].next = freeTimers;
+        freeTimers = &timerPool[i - 1];
+    }
+    pendingHead = NULL;
+    
+    // The timer runs free over its full width, deadlines are matched against its count by the output compare
+    HR_COMPARE_CFG_REG = HR_COMPARE_CFG_WORD & ~(1 << HR_COMPARE_CFG_EN_BIT);
+    HR_TIMER_CFG_REG = HR_TIMER_CFG_WORD & ~(1 << HR_TIMER_CFG_EN_BIT);
+    HR_TIMER_PR_REG = HRTIMER_FREE_RUNNING;
+    HR_TIMER_CFG_REG |= 1 << HR_TIMER_CFG_EN_BIT;
+    interrupt_clr_flag(HR_COMPARE_INTERRUPT);
+    interrupt_enable(HR_COMPARE_INTERRUPT, HRTIMER_INTERRUPT_PRIORITY);
+    
+    return true;
+}
+
+struct HrTimer* hrtimer_create(const HrTimerHandle handle, void* context)
+{
+    struct HrTimer* timer;
+    
+    if(handle == NULL)
+        return NULL;
+    
+    // Handles may create and invalidate timers from the interrupt
+    const unsigned long status = __builtin_disable_interrupts();
+    timer = freeTimers;
+    if(timer != NULL)
+        freeTimers = timer->next;
+    _CP0_SET_STATUS(status);
+    if(timer == NULL)
+        return NULL;
+    
+    timer->handle = handle;
+    timer->context = context;
+    timer->deadline = 0;
+    timer->next = NULL;
+    timer->opt.pending = 0;
+    timer->opt.assigned = 1;
+    return timer;
+}
+
+void hrtimer_invalidate(struct HrTimer* timer)
+{
+    ASSERT(timer != NULL);
+    
+    if(!timer->opt.assigned)
+        return;
+    
+    const unsigned long status = __builtin_disable_interrupts();
+    if(queue_remove(timer))
+        hrtimer_program();
+    timer->opt.assigned = 0;
+    timer->next = freeTimers;
+    freeTimers = timer;
+    _CP0_SET_STATUS(status);
+}
+
+void hrtimer_start(struct HrTimer* timer, const unsigned long delay)
+{
+    ASSERT(timer != NULL);
+    
+    const unsigned long status = __builtin_disable_interrupts();
+    hrtimer_schedule(timer, HR_TIMER + hrTicks(delay));
+    _CP0_SET_STATUS(status); // Restore the previous interrupt state
+}
+
+void hrtimer_advance(struct HrTimer* timer, const unsigned long delay)
+{
+    ASSERT(timer != NULL);
+    
+    const unsigned long status = __builtin_disable_interrupts();
+    hrtimer_schedule(timer, timer->deadline + hrTicks(delay));
+    _CP0_SET_STATUS(status); // Restore the previous interrupt state
+}
+
+void hrtimer_cancel(struct HrTimer* timer)
+{
+    ASSERT(timer != NULL);
+    
+    const unsigned long status = __builtin_disable_interrupts();
+    if(queue_remove(timer))
+        hrtimer_program();
+    _CP0_SET_STATUS(status); // Restore the previous interrupt state
+}
+
+unsigned char hrtimer_is_pending(const struct HrTimer* timer)
+{
+    ASSERT(timer != NULL);
+    
+    return timer->opt.pending;
+}
+
+void __ISR(HR_COMPARE_VECTOR, HRTIMER_INTERRUPT_IPL) hrtimer_interrupt(void)
+{
+    SCHEDULER_ISR_ENTER();
+    
+    struct HrTimer* timer;
+    unsigned long status;
+    
+    // Cleared before the queue is examined, so a match from here on interrupts again
+    interrupt_clr_flag(HR_COMPARE_INTERRUPT);
+    
+    // Execute all due handles, the count keeps running so deadlines set by the handles stay exact
+    for(;;) {
+        status = __builtin_disable_interrupts();
+        timer = pendingHead;
+        if(timer != NULL && isDue(timer->deadline, HR_TIMER))
+            queue_remove(timer);
+        else
+            timer = NULL;
+        _CP0_SET_STATUS(status);
+        
+        if(timer == NULL)
+            break;
+        (*timer->handle)(timer, timer->context);
+    }
+    
+    status = __builtin_disable_interrupts();
+    hrtimer_program();
+    _CP0_SET_STATUS(status);
+    
+    SCHEDULER_ISR_EXIT();
+}
+
+void hrtimer_program()
+{
+    if(pendingHead == NULL) {
+        HR_COMPARE_CFG_REG &= ~(1 << HR_COMPARE_CFG_EN_BIT); // Nothing pending, no match is needed
+        return;
+    }
+    
+    // Match on the earliest deadline, a deadline that has passed or is too close matches as soon as possible
+    const unsigned long count = HR_TIMER;
+    unsigned long target = pendingHead->deadline;
+    if((long)(target - count) < HRTIMER_MIN_TICKS)
+        target = count + HRTIMER_MIN_TICKS;
+    HR_COMPARE_REG = target;
+    HR_COMPARE_CFG_REG |= 1 << HR_COMPARE_CFG_EN_BIT;
+}
+
+void hrtimer_schedule(struct HrTimer* timer, const unsigned long deadline)
+{
+    bool wasHead = (timer == pendingHead);
+    
+    queue_remove(timer);
+    timer->deadline = deadline;
+    queue_insert(timer);
+    if(wasHead || timer == pendingHead)
+        hrtimer_program();
+}
+
+void queue_insert(struct HrTimer* timer)
+{
+    struct HrTimer** link = &pendingHead;
+    
+    // Timers with an equal deadline keep the order in which they were started
+    while(*link != NULL && isDue((*link)->deadline, timer->deadline))
+        link = &(*link)->next;
+    timer->next = *link;
+    *link = timer;
+    timer->opt.pending = 1;
+}
+
+bool queue_remove(struct HrTimer* timer)
+{
+    struct HrTimer** link = &pendingHead;
+    bool wasHead = (timer == pendingHead);
+    
+    if(!timer->opt.pending)
+        return false;
+    
+    while(*link != timer)
+        link = &(*link)->next;
+    *link = timer->next;
+    timer->next = NULL;
+    timer->opt.pending = 0;
+    return wasHead;
+}
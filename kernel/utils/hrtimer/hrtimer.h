@@ -0,0 +1,67 @@
+#ifndef HRTIMER_H
+#define HRTIMER_H
+
+#include "cfg/hrtimer_config.h"
+#include "../../../lib/std/stdtypes.h"
+
+/*
+ * One-shot timers with microsecond resolution on a dedicated 32 bit hardware timer, which runs free over its full width.
+ * Pending timers are kept in a queue sorted on their deadline, an output compare matches the earliest one against the count.
+ * Handles are executed from the timer interrupt, at HRTIMER_INTERRUPT_PRIORITY.
+ */
+
+struct HrTimer;
+
+typedef void (*HrTimerHandle)(struct HrTimer* timer, void* context);
+
+/**
+ * Initializes the high resolution timer pool and its hardware timer
+ * @return Returns 'true' on success, otherwise 'false'
+ * @note This function will invalidate the timer pool, meaning no timer should be created before this function is called
+ */
+bool hrtimer_init();
+
+/**
+ * Claims a high resolution timer from the pool
+ * @param handle The handle that is executed from the timer interrupt once the timer expires
+ * @param context User data passed to the handle together with the timer
+ * @return Returns a pointer to the created timer or 'NULL' when the pool is exhausted
+ */
+struct HrTimer* hrtimer_create(const HrTimerHandle handle, void* context);
+
+/**
+ * Cancels a high resolution timer and returns it to the pool
+ * @param timer The timer to be invalidated
+ */
+void hrtimer_invalidate(struct HrTimer* timer);
+
+/**
+ * Starts a high resolution timer, a pending timer is rescheduled
+ * @param timer The timer to start
+ * @param delay The delay in microseconds from now
+ * @note Delays must stay below 2^31 timer ticks, about 214 seconds with the default 1:8 prescaler at an 80 MHz PBCLK
+ */
+void hrtimer_start(struct HrTimer* timer, const unsigned long delay);
+
+/**
+ * Starts a high resolution timer relative to its previous deadline instead of now
+ * @param timer The timer to start
+ * @param delay The delay in microseconds from the previous deadline
+ * @note Intended to be called from the handle, chained deadlines do not accumulate the interrupt latency
+ */
+void hrtimer_advance(struct HrTimer* timer, const unsigned long delay);
+
+/**
+ * Cancels a pending high resolution timer, its handle will not be executed
+ * @param timer The timer to cancel
+ */
+void hrtimer_cancel(struct HrTimer* timer);
+
+/**
+ * Checks if a high resolution timer is pending
+ * @param timer The timer to be checked
+ * @return Returns '1' if the timer is pending otherwise '0'
+ */
+unsigned char hrtimer_is_pending(const struct HrTimer* timer);
+
+#endif /* HRTIMER_H */
@@ -1,26 +1,149 @@
 #include "timer.h"
 #include "../../scheduler/scheduler.h"
+#include "../../../peripheral/interrupt/interrupt.h"
 #include "../../../lib/print/assert.h"
+#include <xc.h>
+#include <sys/attribs.h>
 #include <stddef.h>
+#include <limits.h>
 
 #define TIMER_POOL_SIZE_DEFAULT     25   
-#define TIMER_POOL_MAX              100
+#define TIMER_POOL_MAX              500
+#define TIMER_WHEEL_BITS_DEFAULT    6
+#define TIMER_WHEEL_LEVELS_DEFAULT  4
+
+#ifdef TIMER_WHEEL_BITS
+    #if (TIMER_WHEEL_BITS < 1) || (TIMER_WHEEL_BITS > 8)
+        #error "Timer wheel bits must be within 1 and 8"
+    #else
+        #define WHEEL_BITS  TIMER_WHEEL_BITS
+    #endif
+#else
+    #define WHEEL_BITS      TIMER_WHEEL_BITS_DEFAULT
+#endif
+
+#ifdef TIMER_WHEEL_LEVELS
+    #if (TIMER_WHEEL_LEVELS < 1) || ((TIMER_WHEEL_LEVELS * WHEEL_BITS) > 31)
+        #error "Timer wheel levels must be a non negative integer with a minimum of 1, spanning at most 31 bits"
+    #else
+        #define WHEEL_LEVELS    TIMER_WHEEL_LEVELS
+    #endif
+#else
+    #define WHEEL_LEVELS        TIMER_WHEEL_LEVELS_DEFAULT
+#endif
+
+#ifdef TIMER_HANDLE_BUDGET
+    #if (TIMER_HANDLE_BUDGET < 1)
+        #error "Timer handle budget must be a non negative integer with a minimum of 1"
+    #endif
+#endif
+
+#ifdef TIMER_HARDWARE_TICK
+    #if !defined(_TMR1)
+        #error "No hardware timer available for the timer tick"
+    #endif
+
+    #define TICK_TIMER              TMR1
+    #define TICK_TIMER_PR_REG       PR1
+    #define TICK_TIMER_CFG_REG      T1CON
+    #define TICK_TIMER_CFG_WORD     0x0010 // Timer off; 1:8 prescaler
+    #define TICK_TIMER_PRESCALER    8
+    #define TICK_TIMER_CFG_EN_BIT   15
+    #define TICK_TIMER_INTERRUPT    INTERRUPT_TIMER1
+    #define TICK_TIMER_VECTOR       _TIMER_1_VECTOR
+
+    #if defined(_SYS_CLK) && defined(_PB_DIV)
+        #define TICK_TIMER_FREQUENCY    ((_SYS_CLK / _PB_DIV) / TICK_TIMER_PRESCALER)
+    #elif defined(PBCLK_FREQUENCY)
+        #define TICK_TIMER_FREQUENCY    (PBCLK_FREQUENCY / TICK_TIMER_PRESCALER)
+    #else
+        #error "Timer tick could not be calculated, please define the PBCLK_FREQUENCY in scheduler_config.h or _SYS_CLK and _PB_DIV globally."
+    #endif
+
+    #define TICK_TIMER_PERIOD       (((TICK_TIMER_FREQUENCY / 1000LU) * TIMER_TICK_INTERVAL) / 1000LU - 1)
+    #if (TICK_TIMER_PERIOD > 0xFFFF) || (TICK_TIMER_PERIOD < 1)
+        #error "Timer tick interval does not fit the 16 bit tick timer, change the prescaler or the tick interval"
+    #endif
+
+    #define timerLock()             __builtin_disable_interrupts() // The wheel and the expired queue are shared with the tick interrupt
+    #define timerUnlock(status)     _CP0_SET_STATUS(status)
+#else
+    #define timerLock()             0
+    #define timerUnlock(status)     ((void)(status))
+#endif
+
+#if defined(_SYS_CLK)
+    #define CORE_TICK_FREQUENCY     (_SYS_CLK / 2) // Core timer increments every other system clock
+#elif defined(SYSCLK_FREQUENCY)
+    #define CORE_TICK_FREQUENCY     (SYSCLK_FREQUENCY / 2)
+#else
+    #error "Core tick could not be calculated, please define the SYSCLK_FREQUENCY in scheduler_config.h or _SYS_CLK globally."
+#endif
+
+#define WHEEL_SIZE                  (1LU << WHEEL_BITS)
+#define WHEEL_MASK                  (WHEEL_SIZE - 1)
+#define WHEEL_MAX_DELTA             ((1LU << (WHEEL_BITS * WHEEL_LEVELS)) - 1) // Longer time-outs are placed at the end and re-placed when reached
+#define wheelIndex(tick, level)     (((tick) >> (WHEEL_BITS * (level))) & WHEEL_MASK)
+#define isRunning(timer)            ((timer)->opt.assigned && !(timer)->opt.suspended) // Running timers are exactly the ones in the wheel
 
 struct Timer
 {
-    unsigned long interval;
-    unsigned long ticks;
     TimerHandle handle;
+    void* context; // Passed to the handle
+    struct Timer* next; // Next timer in the wheel slot, or in the free list when unassigned
+    union {
+        struct {
+            unsigned long interval; // In timer ticks
+            unsigned long expires; // Absolute timer tick at which the timer times out
+            struct Timer** link; // The pointer referring to this timer in the wheel slot
+            struct Timer* nextExpired; // Next timer waiting for its handle to be executed
+        };
+        struct { // Measure timers never enter the wheel
+            unsigned long lapStart; // Core timer count at the start of the current lap
+            unsigned long measureStart; // Core timer count at the start of the measurement
+            unsigned long minCycles;
+            unsigned long maxCycles;
+            unsigned long long totalCycles;
+            unsigned long laps;
+        };
+    };
     struct {
         unsigned char type        :3;
         unsigned char assigned    :1;
-        unsigned char suspended   :1;
+        unsigned char suspended   :1; // Always set for measure timers
         unsigned char timedout    :1;
-        unsigned char reserved    :2;
+        unsigned char expired     :1; // Waiting in the expired queue for its handle to be executed
+        unsigned char measuring   :1;
     } opt;
 };
 
 static unsigned long timer_calc_systicks(unsigned int time, const enum TimerUnit unit);
+static void timer_arm(struct Timer* timer);
+static void measure_record(struct Timer* timer, const unsigned long cycles);
+static void timer_expire(struct Timer* timer);
+static void wheel_insert(struct Timer* timer);
+static void wheel_remove(struct Timer* timer);
+static void wheel_advance();
+static void wheel_cascade(const size_t level);
+static void expired_push(struct Timer* timer);
+static struct Timer* expired_pop();
+static void expired_remove(struct Timer* timer);
+#ifdef TIMER_HARDWARE_TICK
+static void timer_deferred(void* arg);
+#endif
+
+#ifdef TIMER_HARDWARE_TICK
+static volatile bool dispatchPosted = false; // The tick interrupt posted 'timer_deferred' and it has not started yet
+#else
+static SchedulerTicks tickInterval = 0;
+static SchedulerTicks lastTick = 0;
+#endif
+static unsigned long wheelTick = 0; // Timer ticks processed by the wheel, wraps around
+static size_t nWheelTimers = 0;
+static struct Timer* wheel[WHEEL_LEVELS][WHEEL_SIZE];
+static struct Timer* freeTimers = NULL;
+static struct Timer* expiredHead = NULL;
+static struct Timer* expiredTail = NULL;
 
 #ifdef TIMER_POOL_SIZE
     #if (TIMER_POOL_SIZE < 1)
@@ -38,81 +161,108 @@ static unsigned long timer_calc_systicks(unsigned int time, const enum TimerUnit
 
 bool timer_init()
 {
-    // Invalidate all timers
-    size_t i;
-    for(i = 0; i < nTimers; ++i)
-        timerPool[i].opt.assigned = 0;
+    // Invalidate all timers and chain them into the free list
+    size_t i, j;
+    freeTimers = NULL;
+    for(i = nTimers; i > 0; --i) {
+        timerPool[i - 1].opt.assigned = 0;
+        timerPool[i - 1].next = freeTimers;
+        freeTimers = &timerPool[i - 1];
+    }
+    for(i = 0; i < WHEEL_LEVELS; ++i) {
+        for(j = 0; j < WHEEL_SIZE; ++j)
+            wheel[i][j] = NULL;
+    }
+    wheelTick = 0;
+    nWheelTimers = 0;
+    expiredHead = NULL;
+    expiredTail = NULL;
     
-    return (bool)(scheduler_create_event(timer_execute, TIMER_TICK_INTERVAL, SCHEDULER_UNIT_US, PRIO_NORMAL));
+#if defined(TIMER_HARDWARE_TICK)
+    // Timer ticks are counted by the tick interrupt, which posts the expired handles to the scheduler
+    dispatchPosted = false;
+    TICK_TIMER_CFG_REG = TICK_TIMER_CFG_WORD & ~(1 << TICK_TIMER_CFG_EN_BIT);
+    TICK_TIMER = 0;
+    TICK_TIMER_PR_REG = TICK_TIMER_PERIOD;
+    interrupt_clr_flag(TICK_TIMER_INTERRUPT);
+    interrupt_enable(TICK_TIMER_INTERRUPT, TIMER_TICK_PRIORITY);
+    TICK_TIMER_CFG_REG |= 1 << TICK_TIMER_CFG_EN_BIT;
+    return true;
+#else
+    // Timer ticks are derived from the scheduler's timebase
+    tickInterval = scheduler_calc_ticks(TIMER_TICK_INTERVAL, SCHEDULER_UNIT_US);
+    lastTick = scheduler_get_ticks();
+    
+#ifdef TIMER_STATIC_EVENT
+    return true;
+#else
+    return (scheduler_create_event(timer_execute, TIMER_TICK_INTERVAL, SCHEDULER_UNIT_US, PRIO_NORMAL) != SCHEDULER_ID_INVALID);
+#endif
+#endif
 }
 
 void timer_execute()
 {
-    TimerHandle handle = NULL;
-    
-    size_t i;
-    struct Timer* timer = timerPool;
-    for(i = 0; i < nTimers; ++i) {
-        if(timer->opt.assigned && !timer->opt.suspended) {
-            
-            // Decrement tick count
-            if(timer->ticks > 0)
-                timer->opt.timedout = !!!(--timer->ticks); // Determine if timer timed out after decrement.
-            else 
-                timer->opt.timedout = 1;
-            
-            if(timer->opt.timedout) {
-                switch(timer->opt.type) {
-                    case TIMER_SOFT:
-                        if(handle == NULL) { // Yay, we can execute this timer's handle
-                            timer->ticks = timer->interval; // Reset tick count
-                            timer->opt.timedout = 0;
-                            handle = timer->handle; 
-                        }
-                        break;
-                    case TIMER_SINGLE_SHOT:
-                        if(handle == NULL) {
-                            timer->opt.suspended = 1;
-                            handle = timer->handle;
-                        } 
-                        break;
-                    case TIMER_COUNTDOWN:
-                        timer->opt.suspended = 1;
-                        break;
-                    default:
-                        break;
-                }
-            }
-        }
-        timer++; // Advance to next timer
+#ifndef TIMER_HARDWARE_TICK
+    unsigned long elapsed = 0;
+    
+    // Count the ticks that passed on the shared timebase, so a late call does not lose time
+    SchedulerTicks now = scheduler_get_ticks();
+    while(now - lastTick >= tickInterval) {
+        lastTick += tickInterval;
+        elapsed++;
     }
     
-    if(handle != NULL)
-        (*handle)(timer);
+    if(nWheelTimers == 0)
+        wheelTick += elapsed; // Nothing can expire, skip ahead
+    else {
+        while(elapsed-- > 0)
+            wheel_advance();
+    }
+#endif
+    
+    // Execute the handles of all expired timers, or as many as the budget allows
+    struct Timer* timer;
+    unsigned long status;
+#ifdef TIMER_HANDLE_BUDGET
+    size_t budget = TIMER_HANDLE_BUDGET;
+    while(budget-- > 0) {
+#else
+    for(;;) {
+#endif
+        status = timerLock();
+        timer = expired_pop();
+        timerUnlock(status);
+        if(timer == NULL)
+            break;
+        (*timer->handle)(timer, timer->context);
+    }
 }
 
-struct Timer* timer_create(const enum TimerType type, const TimerHandle handle)
+struct Timer* timer_create(const enum TimerType type, const TimerHandle handle, void* context)
 {
     struct Timer* timer = NULL;
     if(type >= TIMER_COUNT)
         return timer;
     
-    size_t i;
-    for(i = 0; i < nTimers; ++i) {
-        if(!timerPool[i].opt.assigned) {
-            timer = &timerPool[i];
-            break;
-        }
-    }
-    
+    timer = freeTimers;
     if(timer != NULL) { // Timer was found
+        freeTimers = timer->next;
         timer->interval = 0;
-        timer->ticks = 0;
+        timer->expires = 0;
         timer->handle = handle;
+        timer->context = context;
+        timer->next = NULL;
+        timer->link = NULL;
+        timer->nextExpired = NULL;
         timer->opt.type = type;
         timer->opt.suspended = 1;
         timer->opt.timedout = 0;
+        timer->opt.expired = 0;
+        timer->opt.measuring = 0;
         timer->opt.assigned = 1;
+        if(type == TIMER_MEASURE)
+            timer_measure_reset(timer);
     }
      
     return timer;
@@ -122,41 +272,72 @@ void timer_invalidate(struct Timer* timer)
 {
     ASSERT(timer != NULL);
     
+    if(!timer->opt.assigned)
+        return;
+    
+    const unsigned long status = timerLock();
+    if(isRunning(timer))
+        wheel_remove(timer);
+    expired_remove(timer);
     timer->opt.assigned = 0;
+    timer->next = freeTimers;
+    freeTimers = timer;
+    timerUnlock(status);
 }
 
 void timer_set_time(struct Timer* timer, const unsigned int time, const enum TimerUnit unit)
 {
     ASSERT(timer != NULL);
     
+    if(timer->opt.type == TIMER_MEASURE)
+        return; // Shares its storage with the time-out
+    
+    const unsigned long status = timerLock();
     timer->interval = timer_calc_systicks(time, unit);
-    timer->ticks = timer->interval;
+    if(isRunning(timer)) {
+        wheel_remove(timer);
+        timer_arm(timer);
+    }
+    timerUnlock(status);
 }
 
 void timer_start(struct Timer* timer, const unsigned int time, const enum TimerUnit unit)
 {
     ASSERT(timer != NULL);
     
+    if(timer->opt.type == TIMER_MEASURE)
+        return;
+    
     timer->interval = timer_calc_systicks(time, unit);
-    timer->ticks = timer->interval;
-    timer->opt.timedout = 0;
-    timer->opt.suspended = 0;
+    timer_restart(timer);
 }
 
 void timer_stop(struct Timer* timer)
 {
     ASSERT(timer != NULL);
     
+    const unsigned long status = timerLock();
+    if(isRunning(timer))
+        wheel_remove(timer);
+    expired_remove(timer); // A stopped timer does not execute its handle anymore, even when it already expired
     timer->opt.suspended = 1; // Suspend timer
+    timerUnlock(status);
 }
 
 void timer_restart(struct Timer* timer)
 {
     ASSERT(timer != NULL);
     
-    timer->ticks = timer->interval;
+    if(timer->opt.type == TIMER_MEASURE)
+        return;
+    
+    const unsigned long status = timerLock();
+    if(isRunning(timer))
+        wheel_remove(timer);
     timer->opt.timedout = 0;
     timer->opt.suspended = 0;
+    timer_arm(timer);
+    timerUnlock(status);
 }
 
 unsigned char timer_timed_out(const struct Timer* timer)
@@ -177,23 +358,278 @@ unsigned char timer_is_valid(const struct Timer* timer)
     return timer->opt.assigned;
 }
 
+void timer_measure_start(struct Timer* timer)
+{
+    ASSERT(timer != NULL && timer->opt.type == TIMER_MEASURE);
+    
+    timer->opt.measuring = 1;
+    timer->measureStart = _CP0_GET_COUNT();
+    timer->lapStart = timer->measureStart;
+}
+
+unsigned long timer_measure_lap(struct Timer* timer)
+{
+    ASSERT(timer != NULL && timer->opt.type == TIMER_MEASURE);
+    
+    const unsigned long now = _CP0_GET_COUNT();
+    if(!timer->opt.measuring)
+        return 0;
+    
+    const unsigned long cycles = now - timer->lapStart;
+    measure_record(timer, cycles);
+    timer->lapStart = now;
+    return cycles;
+}
+
+unsigned long timer_measure_stop(struct Timer* timer)
+{
+    ASSERT(timer != NULL && timer->opt.type == TIMER_MEASURE);
+    
+    const unsigned long now = _CP0_GET_COUNT();
+    if(!timer->opt.measuring)
+        return 0;
+    
+    measure_record(timer, now - timer->lapStart);
+    timer->opt.measuring = 0;
+    return now - timer->measureStart;
+}
+
+void timer_measure_reset(struct Timer* timer)
+{
+    ASSERT(timer != NULL && timer->opt.type == TIMER_MEASURE);
+    
+    timer->minCycles = ULONG_MAX;
+    timer->maxCycles = 0;
+    timer->totalCycles = 0;
+    timer->laps = 0;
+}
+
+unsigned long timer_measure_count(const struct Timer* timer)
+{
+    ASSERT(timer != NULL && timer->opt.type == TIMER_MEASURE);
+    
+    return timer->laps;
+}
+
+unsigned long timer_measure_min(const struct Timer* timer)
+{
+    ASSERT(timer != NULL && timer->opt.type == TIMER_MEASURE);
+    
+    return (timer->laps > 0) ? timer->minCycles : 0;
+}
+
+unsigned long timer_measure_max(const struct Timer* timer)
+{
+    ASSERT(timer != NULL && timer->opt.type == TIMER_MEASURE);
+    
+    return timer->maxCycles;
+}
+
+unsigned long timer_measure_mean(const struct Timer* timer)
+{
+    ASSERT(timer != NULL && timer->opt.type == TIMER_MEASURE);
+    
+    return (timer->laps > 0) ? (unsigned long)(timer->totalCycles / timer->laps) : 0;
+}
+
+unsigned long timer_cycles_to_us(const unsigned long cycles)
+{
+    return (unsigned long)(((unsigned long long)cycles * 1000000LU) / CORE_TICK_FREQUENCY);
+}
+
+#ifdef TIMER_HARDWARE_TICK
+void __ISR(TICK_TIMER_VECTOR, TIMER_TICK_IPL) timer_tick_interrupt(void)
+{
+    SCHEDULER_ISR_ENTER();
+    
+    interrupt_clr_flag(TICK_TIMER_INTERRUPT);
+    if(nWheelTimers == 0)
+        wheelTick++; // Nothing can expire, skip ahead
+    else
+        wheel_advance();
+    
+    // Handles are executed from the main loop, a single post covers all timers that expire before it runs
+    if(expiredHead != NULL && !dispatchPosted)
+        dispatchPosted = scheduler_post(timer_deferred, NULL); // Retried on the next tick when the post queue is full
+    
+    SCHEDULER_ISR_EXIT();
+}
+#endif
+
 static unsigned long timer_calc_systicks(unsigned int time, const enum TimerUnit unit)
 {
-    unsigned long ticks;
+    unsigned long long ticks; // Seconds and milliseconds overflow 32 bit microseconds, a time-out of 2^32 ticks is over 24 days
     switch(unit) {
         default: // Default to microseconds
         case TIMER_UNIT_US:
             ticks = time / TIMER_TICK_INTERVAL; 
             break;
         case TIMER_UNIT_MS:
-            ticks = (time * 1000LU) / TIMER_TICK_INTERVAL;
+            ticks = ((unsigned long long)time * 1000LU) / TIMER_TICK_INTERVAL;
             break;
         case TIMER_UNIT_S:
-            //@Todo: Currently limited to 12 bits, fixme?
-            if(time > 4096)
-                time = 4096;
-            ticks = (time * 1000000LU) / TIMER_TICK_INTERVAL;
+            ticks = ((unsigned long long)time * 1000000LU) / TIMER_TICK_INTERVAL;
             break;
     }
-    return ticks;
-}
\ No newline at end of file
+    return (ticks > ULONG_MAX) ? ULONG_MAX : (unsigned long)ticks;
+}
+
+void timer_arm(struct Timer* timer)
+{
+    // A time-out of zero ticks expires on the next tick
+    timer->expires = wheelTick + ((timer->interval > 0) ? timer->interval : 1);
+    wheel_insert(timer);
+}
+
+void measure_record(struct Timer* timer, const unsigned long cycles)
+{
+    if(cycles < timer->minCycles)
+        timer->minCycles = cycles;
+    if(cycles > timer->maxCycles)
+        timer->maxCycles = cycles;
+    timer->totalCycles += cycles;
+    timer->laps++;
+}
+
+void timer_expire(struct Timer* timer)
+{
+    timer->opt.timedout = 1;
+    switch(timer->opt.type) {
+        case TIMER_SOFT:
+            // Re-arm on the original schedule, so a delayed handle does not shift the period
+            timer->expires += (timer->interval > 0) ? timer->interval : 1;
+            wheel_insert(timer);
+            if(timer->handle != NULL)
+                expired_push(timer);
+            else
+                timer->opt.timedout = 0;
+            break;
+        case TIMER_SINGLE_SHOT:
+            timer->opt.suspended = 1;
+            if(timer->handle != NULL)
+                expired_push(timer);
+            break;
+        case TIMER_COUNTDOWN:
+            timer->opt.suspended = 1;
+            break;
+        default:
+            break;
+    }
+}
+
+void wheel_insert(struct Timer* timer)
+{
+    unsigned long delta = timer->expires - wheelTick;
+    size_t level = 0;
+    
+    if(delta > WHEEL_MAX_DELTA)
+        delta = WHEEL_MAX_DELTA;
+    
+    // The level is chosen on the distance, the slot on the absolute expiry tick
+    while(level < (WHEEL_LEVELS - 1) && delta >= (1LU << (WHEEL_BITS * (level + 1))))
+        level++;
+    struct Timer** slot = &wheel[level][wheelIndex(wheelTick + delta, level)];
+    
+    timer->next = *slot;
+    if(timer->next != NULL)
+        timer->next->link = &timer->next;
+    timer->link = slot;
+    *slot = timer;
+    nWheelTimers++;
+}
+
+void wheel_remove(struct Timer* timer)
+{
+    *timer->link = timer->next;
+    if(timer->next != NULL)
+        timer->next->link = timer->link;
+    timer->next = NULL;
+    timer->link = NULL;
+    nWheelTimers--;
+}
+
+void wheel_advance()
+{
+    wheelTick++;
+    
+    // Each time a level wraps around, the next slot of the level above is spread over the levels below
+    size_t level = 1;
+    while(level < WHEEL_LEVELS && wheelIndex(wheelTick, level - 1) == 0) {
+        wheel_cascade(level);
+        level++;
+    }
+    
+    // Everything left in the current slot of the lowest level expires at this very tick
+    struct Timer* timer = wheel[0][wheelIndex(wheelTick, 0)];
+    while(timer != NULL) {
+        struct Timer* next = timer->next;
+        wheel_remove(timer);
+        timer_expire(timer);
+        timer = next;
+    }
+}
+
+void wheel_cascade(const size_t level)
+{
+    struct Timer* timer = wheel[level][wheelIndex(wheelTick, level)];
+    while(timer != NULL) {
+        struct Timer* next = timer->next;
+        wheel_remove(timer);
+        wheel_insert(timer);
+        timer = next;
+    }
+}
+
+void expired_push(struct Timer* timer)
+{
+    if(timer->opt.expired)
+        return; // Still waiting from a previous time-out
+    
+    timer->opt.expired = 1;
+    timer->nextExpired = NULL;
+    if(expiredTail != NULL)
+        expiredTail->nextExpired = timer;
+    else
+        expiredHead = timer;
+    expiredTail = timer;
+}
+
+struct Timer* expired_pop()
+{
+    struct Timer* timer = expiredHead;
+    if(timer != NULL) {
+        expiredHead = timer->nextExpired;
+        if(expiredHead == NULL)
+            expiredTail = NULL;
+        timer->opt.expired = 0;
+        if(timer->opt.type == TIMER_SOFT)
+            timer->opt.timedout = 0;
+    }
+    return timer;
+}
+
+void expired_remove(struct Timer* timer)
+{
+    struct Timer** link = &expiredHead;
+    struct Timer* previous = NULL;
+    
+    if(!timer->opt.expired)
+        return;
+    
+    while(*link != timer) {
+        previous = *link;
+        link = &(*link)->nextExpired;
+    }
+    *link = timer->nextExpired;
+    if(expiredTail == timer)
+        expiredTail = previous;
+    timer->opt.expired = 0;
+}
+
+#ifdef TIMER_HARDWARE_TICK
+void timer_deferred(void* arg)
+{
+    dispatchPosted = false; // Timers that expire from here on are posted again
+    timer_execute();
+}
+#endif
\ No newline at end of file
@@ -1,21 +1,36 @@
 #ifndef TIMER_H
 #define	TIMER_H
 
+#include "../../scheduler/cfg/scheduler_config.h"
 #include "../../../lib/std/stdtypes.h"
 
 #define TIMER_TICK_INTERVAL     500 // In microseconds
 #define TIMER_POOL_SIZE         10
+#define TIMER_WHEEL_BITS        6   // Each level of the timing wheel has 2^bits slots
+#define TIMER_WHEEL_LEVELS      4   // Levels of the timing wheel, time-outs up to 2^(bits * levels) ticks are placed exactly
+//#define TIMER_HANDLE_BUDGET     8   // Maximum number of handles executed per call, the remainder is executed on the next call
+//#define TIMER_HARDWARE_TICK     // The wheel is advanced from the TMR1 interrupt and handles are posted to the scheduler
+#define TIMER_TICK_PRIORITY     INTERRUPT_PRIORITY_3    // Priority of the hardware tick, the interrupt only advances the wheel
+#define TIMER_TICK_IPL          IPL3AUTO                // Must match the tick priority
+
+// With the cyclic executive 'timer_execute' is listed in the static event table of the scheduler instead of being created on init
+#if defined(SCHEDULER_CYCLIC_EXECUTIVE) && !defined(TIMER_HARDWARE_TICK)
+    #define TIMER_STATIC_EVENT
+    #define TIMER_STATIC_EVENTS(X)  X(timer_execute, 1, 0)
+#else
+    #define TIMER_STATIC_EVENTS(X)
+#endif
 
 struct Timer;
 
-typedef void(*TimerHandle)(struct Timer* timer);
+typedef void(*TimerHandle)(struct Timer* timer, void* context);
 
 enum TimerType
 {
     TIMER_SOFT = 0,     // A timer that keeps firing at a specific interval, handle is executed on each timeout
     TIMER_SINGLE_SHOT,  // A timer that fires only once after it expired, handle is executed on timeout
     TIMER_COUNTDOWN,    // A timer that simply counts down and sets the timeout flag once it has expired
-    // @Todo: TIMER_MEASURE
+    TIMER_MEASURE,      // A stopwatch on the core timer that accumulates the min, max and mean of its laps, see timer_measure_start()
     
     TIMER_COUNT
 };
@@ -35,8 +50,12 @@ enum TimerUnit
 bool timer_init();
 
 /**
- * A timer event that updates all the timers
- * @note This function must be called at a fixed time interval of 'TIMER_TICK_INTERVAL' microseconds.
+ * A timer event that advances the timing wheel and executes the handles of all expired timers
+ * @note This function should be called at a fixed time interval of 'TIMER_TICK_INTERVAL' microseconds.
+ *       Elapsed time is taken from the scheduler's timebase, so a late call is compensated.
+ *       A tick only touches the timers that expire in it, independent of the number of running timers.
+ *       With TIMER_HARDWARE_TICK the wheel is advanced from the tick interrupt instead, this function then only executes
+ *       the expired handles and is posted to the scheduler by the interrupt itself. The timer API must then not be used from other interrupts.
  */
 void timer_execute();
 
@@ -44,10 +63,11 @@ void timer_execute();
  * Claims a timer from the pool and initializes it
  * @param type The type of the timer
  * @param handle The handle that has to be executed on a timer time-out
+ * @param context User data passed to the handle together with the timer
  * @note The handle should be 'NULL' when a countdown timer is used
  * @return Returns a pointer to the created timer or 'NULL' when an error occured
  */
-struct Timer* timer_create(const enum TimerType type, const TimerHandle handle);
+struct Timer* timer_create(const enum TimerType type, const TimerHandle handle, void* context);
 
 /**
  * Invalidates a timer and returns it to the pool
@@ -60,7 +80,7 @@ void timer_invalidate(struct Timer* timer);
  * @param timer The timer where the time-out will be set
  * @param time The time-out interval
  * @param unit The time unit
- * @note When 'TIMER_UNIT_S' is used the time-out interval will be limited to a 12 bit maximum
+ * @note The time-out interval is limited to 2^32 timer ticks, over 24 days at a tick interval of 500 us
  */
 void timer_set_time(struct Timer* timer, const unsigned int time, const enum TimerUnit unit);
 
@@ -68,13 +88,14 @@ void timer_set_time(struct Timer* timer, const unsigned int time, const enum Tim
  * Sets a time-out interval and starts the timer
  * @param time The time-out interval
  * @param unit The time unit
- * @note When 'TIMER_UNIT_S' is used the time-out interval will be limited to a 12 bit maximum
+ * @note The time-out interval is limited to 2^32 timer ticks, over 24 days at a tick interval of 500 us
  */
 void timer_start(struct Timer* timer, const unsigned int time, const enum TimerUnit unit);
 
 /**
  * Stops a timer
  * @param timer The timer to be stopped
+ * @note A handle that is still waiting to be executed for an earlier time-out is discarded
  */
 void timer_stop(struct Timer* timer);
 
@@ -98,5 +119,67 @@ unsigned char timer_timed_out(const struct Timer* timer);
  */
 unsigned char timer_is_valid(const struct Timer* timer);
     
+/**
+ * Starts a measurement of a measure timer
+ * @param timer The measure timer
+ * @note A single measurement must stay shorter than a wrap of the 32 bit core timer, which counts at half the system clock: about 107 seconds at 80 MHz
+ */
+void timer_measure_start(struct Timer* timer);
+
+/**
+ * Ends the current lap of a measure timer and adds it to the statistics, the measurement continues with the next lap
+ * @param timer The measure timer
+ * @return Returns the duration of the lap in core timer cycles, or '0' when the timer is not measuring
+ */
+unsigned long timer_measure_lap(struct Timer* timer);
+
+/**
+ * Ends the last lap of a measure timer, adds it to the statistics and stops the measurement
+ * @param timer The measure timer
+ * @return Returns the duration since the start of the measurement in core timer cycles, or '0' when the timer is not measuring
+ */
+unsigned long timer_measure_stop(struct Timer* timer);
+
+/**
+ * Clears the statistics of a measure timer
+ * @param timer The measure timer
+ */
+void timer_measure_reset(struct Timer* timer);
+
+/**
+ * Gets the number of laps recorded by a measure timer
+ * @param timer The measure timer
+ * @return Returns the number of laps
+ */
+unsigned long timer_measure_count(const struct Timer* timer);
+
+/**
+ * Gets the shortest lap recorded by a measure timer
+ * @param timer The measure timer
+ * @return Returns the shortest lap in core timer cycles, or '0' when nothing was recorded
+ */
+unsigned long timer_measure_min(const struct Timer* timer);
+
+/**
+ * Gets the longest lap recorded by a measure timer
+ * @param timer The measure timer
+ * @return Returns the longest lap in core timer cycles
+ */
+unsigned long timer_measure_max(const struct Timer* timer);
+
+/**
+ * Gets the mean lap recorded by a measure timer
+ * @param timer The measure timer
+ * @return Returns the mean lap in core timer cycles, or '0' when nothing was recorded
+ */
+unsigned long timer_measure_mean(const struct Timer* timer);
+
+/**
+ * Converts core timer cycles to microseconds
+ * @param cycles The number of core timer cycles
+ * @return Returns the time in microseconds
+ */
+unsigned long timer_cycles_to_us(const unsigned long cycles);
+
 #endif	/* TIMER_H */
 
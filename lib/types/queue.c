@@ -1,16 +1,39 @@
 #include "queue.h"
 #include "../print/assert.h"
+#include "../print/print.h"
 #include <stddef.h>
+#include <string.h>
 
 #define QUEUE_POOL_SIZE_DEFAULT     25   
 #define QUEUE_POOL_MAX              100
 
+#define accessOnce(x)               (*(volatile __typeof__(x)*)&(x)) // Forces a single load or store of a variable shared with an interrupt
+#define queueBarrier()              __asm__ volatile("" ::: "memory") // The core executes in order and data memory is not cached, so only the compiler may reorder
+
+// Counters of a SPSC queue are split between the producer and the consumer, so they need no locking either
+#ifdef QUEUE_STATISTICS
+    #define statsAdded(queue, n)    do { (queue)->stats.adds += (n); if(queue_used(queue) > (queue)->stats.highWater) (queue)->stats.highWater = queue_used(queue); } while(0)
+    #define statsDropped(queue, n)  ((queue)->stats.drops += (n))
+    #define statsTaken(queue, n)    ((queue)->stats.takes += (n))
+    #define statsUnderflow(queue)   ((queue)->stats.underflows++)
+#else
+    #define statsAdded(queue, n)    ((void)0)
+    #define statsDropped(queue, n)  ((void)0)
+    #define statsTaken(queue, n)    ((void)0)
+    #define statsUnderflow(queue)   ((void)0)
+#endif
+
 struct Queue
 {
     void* buffer;
-    unsigned int head;
-    unsigned int tail;
+    unsigned int head; // Free running for a SPSC queue, only written by the producer
+    unsigned int tail; // Free running for a SPSC queue, only written by the consumer
     unsigned int length;
+    unsigned int mask; // Length minus one, indexes a SPSC queue
+#ifdef QUEUE_STATISTICS
+    const char* name;
+    struct QueueStatistics stats;
+#endif
     struct {
         unsigned char assigned :1;
     } opt;
@@ -23,6 +46,23 @@ static inline void __attribute__((always_inline)) buffer_take(const void* buffer
 
 static unsigned char take_back(struct Queue* queue, void* data);
 static unsigned char take_front(struct Queue* queue, void* data);
+static unsigned char spsc_add(struct Queue* queue, const void* data);
+static unsigned char spsc_take(struct Queue* queue, void* data);
+static void buffer_write(const struct Queue* queue, const unsigned int index, const void* data, const unsigned int count);
+static void buffer_read(const struct Queue* queue, const unsigned int index, void* data, const unsigned int count);
+static unsigned int queue_used(const struct Queue* queue);
+
+static const size_t dataSizes[QUEUE_DATA_TYPE_COUNT] =
+{
+#define QUEUE_NEW_TYPE(type, name) sizeof(type),
+    QUEUE_TYPE_TABLE
+#undef QUEUE_NEW_TYPE
+};
+
+// Every size must survive the conversion to an entry of 'dataSizes', also for large custom types
+#define QUEUE_NEW_TYPE(type, name) typedef char queue_##name##_size_must_fit[(sizeof(type) == (__typeof__(dataSizes[0]))sizeof(type)) ? 1 : -1];
+    QUEUE_TYPE_TABLE
+#undef QUEUE_NEW_TYPE
 
 #ifdef QUEUE_POOL_SIZE
     #if (QUEUE_POOL_SIZE < 1)
@@ -52,6 +92,8 @@ struct Queue* queue_create(void* buffer, const unsigned int length, const enum Q
     struct Queue* queue = NULL;
     if(buffer == NULL || length == 0 || type >= QUEUE_TYPE_COUNT || dataType >= QUEUE_DATA_TYPE_COUNT)      
         return queue;
+    if(type == QUEUE_SPSC && (length & (length - 1)) != 0)
+        return queue; // Indexes are masked instead of wrapped
     
     size_t i;
     for(i = 0; i < nQueues; ++i) {
@@ -66,9 +108,14 @@ struct Queue* queue_create(void* buffer, const unsigned int length, const enum Q
         queue->head = 0;
         queue->tail = 0;
         queue->length = length;
+        queue->mask = length - 1;
+#ifdef QUEUE_STATISTICS
+        queue->name = NULL;
+#endif
         queue->type = type;
         queue->dataType = dataType;
         queue->opt.assigned = 1;
+        queue_reset_statistics(queue);
     }
     return queue;
 }
@@ -89,12 +136,21 @@ unsigned char queue_add(struct Queue* queue, const void* data)
         return result;
     
     if(queue->opt.assigned) {
-        unsigned int next = (queue->head + 1) % queue->length;
-        if(next != queue->tail) {
-            buffer_add(queue->buffer, queue->dataType, queue->head, data);
-            queue->head = next;
-            result = 1;
+        if(queue->type == QUEUE_SPSC)
+            result = spsc_add(queue, data);
+        else {
+            unsigned int next = (queue->head + 1) % queue->length;
+            if(next != queue->tail) {
+                buffer_add(queue->buffer, queue->dataType, queue->head, data);
+                queue->head = next;
+                result = 1;
+            }
         }
+        
+        if(result)
+            statsAdded(queue, 1);
+        else
+            statsDropped(queue, 1);
     }
     return result;
 }
@@ -111,12 +167,186 @@ unsigned char queue_take(struct Queue* queue, void* data)
         switch(queue->type) {
             case QUEUE_FIFO:    result = take_back(queue, data);    break;
             case QUEUE_LIFO:    result = take_front(queue, data);   break;
+            case QUEUE_SPSC:    result = spsc_take(queue, data);    break;
             default:                                                break;
         }
+        
+        if(result)
+            statsTaken(queue, 1);
+        else
+            statsUnderflow(queue);
     }
     return result;
 }
 
+unsigned int queue_add_n(struct Queue* queue, const void* data, const unsigned int count)
+{
+    ASSERT(queue != NULL);
+    
+    unsigned int n = 0;
+    if(data == NULL || !queue->opt.assigned)
+        return n;
+    
+    if(queue->type == QUEUE_SPSC) {
+        const unsigned int head = queue->head;
+        const unsigned int space = queue->length - (head - accessOnce(queue->tail));
+        n = (count < space) ? count : space;
+        buffer_write(queue, head & queue->mask, data, n);
+        queueBarrier(); // The elements are stored before they are published
+        accessOnce(queue->head) = head + n;
+    } else {
+        // FIFO and LIFO queues both add at the head, one slot is kept free to tell a full queue from an empty one
+        const unsigned int space = (queue->tail + queue->length - queue->head - 1) % queue->length;
+        n = (count < space) ? count : space;
+        buffer_write(queue, queue->head, data, n);
+        queue->head = (queue->head + n) % queue->length;
+    }
+    statsAdded(queue, n);
+    statsDropped(queue, count - n);
+    return n;
+}
+
+unsigned int queue_take_n(struct Queue* queue, void* data, const unsigned int count)
+{
+    ASSERT(queue != NULL);
+    
+    unsigned int n = 0;
+    if(data == NULL || !queue->opt.assigned)
+        return n;
+    
+    switch(queue->type) {
+        case QUEUE_FIFO: {
+            const unsigned int used = (queue->head + queue->length - queue->tail) % queue->length;
+            n = (count < used) ? count : used;
+            buffer_read(queue, queue->tail, data, n);
+            queue->tail = (queue->tail + n) % queue->length;
+            break;
+        }
+        case QUEUE_LIFO: {
+            // Elements leave in reverse order, which does not map onto a block copy
+            unsigned char* element = (unsigned char*)data;
+            while(n < count && take_front(queue, element)) {
+                element += dataSizes[queue->dataType];
+                n++;
+            }
+            break;
+        }
+        case QUEUE_SPSC: {
+            const unsigned int tail = queue->tail;
+            const unsigned int used = accessOnce(queue->head) - tail;
+            n = (count < used) ? count : used;
+            queueBarrier(); // The elements are loaded after they were published
+            buffer_read(queue, tail & queue->mask, data, n);
+            queueBarrier(); // The elements are loaded before their slots are released
+            accessOnce(queue->tail) = tail + n;
+            break;
+        }
+        default:
+            break;
+    }
+    statsTaken(queue, n);
+    if(n == 0 && count > 0)
+        statsUnderflow(queue);
+    return n;
+}
+
+void* queue_reserve(struct Queue* queue, const unsigned int count, unsigned int* reserved)
+{
+    ASSERT(queue != NULL && reserved != NULL);
+    
+    unsigned int head, space;
+    *reserved = 0;
+    if(!queue->opt.assigned)
+        return NULL;
+    
+    if(queue->type == QUEUE_SPSC) {
+        head = queue->head & queue->mask;
+        space = queue->length - (queue->head - accessOnce(queue->tail));
+    } else {
+        head = queue->head;
+        space = (queue->tail + queue->length - queue->head - 1) % queue->length;
+    }
+    
+    // The region ends at the end of the buffer
+    if(space > queue->length - head)
+        space = queue->length - head;
+    *reserved = (count < space) ? count : space;
+    return (*reserved > 0) ? (unsigned char*)queue->buffer + head * dataSizes[queue->dataType] : NULL;
+}
+
+unsigned int queue_commit(struct Queue* queue, const unsigned int count)
+{
+    ASSERT(queue != NULL);
+    
+    unsigned int n, space;
+    if(!queue->opt.assigned)
+        return 0;
+    
+    // Never publish more than there is space for, which would overwrite elements that are not taken yet
+    if(queue->type == QUEUE_SPSC)
+        space = queue->length - (queue->head - accessOnce(queue->tail));
+    else
+        space = (queue->tail + queue->length - queue->head - 1) % queue->length;
+    n = (count < space) ? count : space;
+    
+    if(queue->type == QUEUE_SPSC) {
+        queueBarrier(); // The elements are stored before they are published
+        accessOnce(queue->head) = queue->head + n;
+    } else
+        queue->head = (queue->head + n) % queue->length;
+    statsAdded(queue, n);
+    return n;
+}
+
+const void* queue_peek_span(const struct Queue* queue, unsigned int* count)
+{
+    ASSERT(queue != NULL && count != NULL);
+    
+    unsigned int tail, used;
+    *count = 0;
+    if(!queue->opt.assigned)
+        return NULL;
+    
+    switch(queue->type) {
+        case QUEUE_FIFO:
+            tail = queue->tail;
+            used = (queue->head + queue->length - queue->tail) % queue->length;
+            break;
+        case QUEUE_SPSC:
+            tail = queue->tail & queue->mask;
+            used = accessOnce(queue->head) - queue->tail;
+            queueBarrier(); // The elements are loaded after they were published
+            break;
+        default:
+            return NULL;
+    }
+    
+    // The region ends at the end of the buffer
+    *count = (used < queue->length - tail) ? used : (queue->length - tail);
+    return (*count > 0) ? (const unsigned char*)queue->buffer + tail * dataSizes[queue->dataType] : NULL;
+}
+
+unsigned int queue_consume(struct Queue* queue, const unsigned int count)
+{
+    ASSERT(queue != NULL);
+    
+    unsigned int n, used;
+    if(!queue->opt.assigned || queue->type == QUEUE_LIFO)
+        return 0;
+    
+    // Never release more than is stored, which would hand out the same elements again
+    used = queue_used(queue);
+    n = (count < used) ? count : used;
+    
+    if(queue->type == QUEUE_SPSC) {
+        queueBarrier(); // The elements are loaded before their slots are released
+        accessOnce(queue->tail) = queue->tail + n;
+    } else
+        queue->tail = (queue->tail + n) % queue->length;
+    statsTaken(queue, n);
+    return n;
+}
+
 void queue_flush(struct Queue* queue)
 {
     ASSERT(queue != NULL);
@@ -132,7 +362,7 @@ unsigned char queue_is_empty(const struct Queue* queue)
     if(!queue->opt.assigned)
         return 1;
     
-    return (queue->head == queue->tail);
+    return (accessOnce(queue->head) == accessOnce(queue->tail));
 }
 
 unsigned char queue_is_full(const struct Queue* queue)
@@ -142,6 +372,9 @@ unsigned char queue_is_full(const struct Queue* queue)
     if(!queue->opt.assigned)
         return 0;
     
+    if(queue->type == QUEUE_SPSC)
+        return (accessOnce(queue->head) - accessOnce(queue->tail) >= queue->length);
+    
     unsigned int next = (queue->head + 1) % queue->length;
     return (next == queue->tail);
 }
@@ -153,6 +386,63 @@ unsigned char queue_is_valid(const struct Queue* queue)
     return queue->opt.assigned;
 }
 
+#ifdef QUEUE_STATISTICS
+void queue_set_name(struct Queue* queue, const char* name)
+{
+    ASSERT(queue != NULL);
+    
+    queue->name = name;
+}
+#endif
+
+bool queue_get_statistics(const struct Queue* queue, struct QueueStatistics* stats)
+{
+    ASSERT(queue != NULL && stats != NULL);
+
+#ifdef QUEUE_STATISTICS
+    if(queue->opt.assigned) {
+        *stats = queue->stats;
+        return true;
+    }
+#else
+    (void)queue;
+    (void)stats;
+#endif
+    return false;
+}
+
+void queue_reset_statistics(struct Queue* queue)
+{
+    ASSERT(queue != NULL);
+
+#ifdef QUEUE_STATISTICS
+    queue->stats.adds = 0;
+    queue->stats.takes = 0;
+    queue->stats.drops = 0;
+    queue->stats.underflows = 0;
+    queue->stats.highWater = queue_used(queue);
+#else
+    (void)queue;
+#endif
+}
+
+void queue_print_statistics()
+{
+#ifdef QUEUE_STATISTICS
+    static const char* const types[QUEUE_TYPE_COUNT] = { "FIFO", "LIFO", "SPSC" };
+    size_t i;
+    
+    print_f("Queue\tName\tType\tLength\tUsed\tHigh\tAdds\tTakes\tDrops\tEmpty takes\r\n");
+    for(i = 0; i < nQueues; ++i) {
+        const struct Queue* queue = &queuePool[i];
+        if(queue->opt.assigned)
+            print_f("Q%d\t%s\t%s\t%d\t%d\t%d\t%d\t%d\t%d\t%d\r\n", i, (queue->name != NULL) ? queue->name : "-",
+                    types[queue->type], queue->length, queue_used(queue), queue->stats.highWater,
+                    queue->stats.adds, queue->stats.takes, queue->stats.drops, queue->stats.underflows);
+    }
+#endif
+}
+
 inline void __attribute__((always_inline)) buffer_add(void* buffer, const enum QueueDataType type, const unsigned int index, const void* data)
 {
     switch(type) {
@@ -209,3 +499,58 @@ unsigned char take_front(struct Queue* queue, void* data)
     buffer_take(queue->buffer, queue->dataType, queue->head, data);
     return 1;
 }
+
+
+unsigned char spsc_add(struct Queue* queue, const void* data)
+{
+    // The head is owned by the producer, the tail can only move forward while it is being read
+    const unsigned int head = queue->head;
+    if(head - accessOnce(queue->tail) >= queue->length)
+        return 0; // Queue is full
+    
+    buffer_add(queue->buffer, queue->dataType, head & queue->mask, data);
+    queueBarrier(); // The element is stored before it is published
+    accessOnce(queue->head) = head + 1;
+    return 1;
+}
+
+unsigned char spsc_take(struct Queue* queue, void* data)
+{
+    // The tail is owned by the consumer, the head can only move forward while it is being read
+    const unsigned int tail = queue->tail;
+    if(accessOnce(queue->head) == tail)
+        return 0; // Queue is empty
+    
+    queueBarrier(); // The element is loaded after it was published
+    buffer_take(queue->buffer, queue->dataType, tail & queue->mask, data);
+    queueBarrier(); // The element is loaded before its slot is released
+    accessOnce(queue->tail) = tail + 1;
+    return 1;
+}
+
+void buffer_write(const struct Queue* queue, const unsigned int index, const void* data, const unsigned int count)
+{
+    // The span is split where it wraps around the end of the buffer
+    const size_t size = dataSizes[queue->dataType];
+    const unsigned int first = (count < queue->length - index) ? count : (queue->length - index);
+    memcpy((unsigned char*)queue->buffer + index * size, data, first * size);
+    if(count > first)
+        memcpy(queue->buffer, (const unsigned char*)data + first * size, (count - first) * size);
+}
+
+void buffer_read(const struct Queue* queue, const unsigned int index, void* data, const unsigned int count)
+{
+    // The span is split where it wraps around the end of the buffer
+    const size_t size = dataSizes[queue->dataType];
+    const unsigned int first = (count < queue->length - index) ? count : (queue->length - index);
+    memcpy(data, (const unsigned char*)queue->buffer + index * size, first * size);
+    if(count > first)
+        memcpy((unsigned char*)data + first * size, queue->buffer, (count - first) * size);
+}
+
+unsigned int queue_used(const struct Queue* queue)
+{
+    if(queue->type == QUEUE_SPSC)
+        return accessOnce(queue->head) - accessOnce(queue->tail);
+    return (queue->head + queue->length - queue->tail) % queue->length;
+}
\ No newline at end of file
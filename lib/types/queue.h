@@ -5,6 +5,7 @@
 #include "../std/stdtypes.h"
 
 #define QUEUE_POOL_SIZE         5
+//#define QUEUE_STATISTICS        // Count adds, takes, drops on a full queue, takes on an empty queue and the high-water mark per queue, see queue_print_statistics()
 
 #define QUEUE_DEFAULT_TYPE_TABLE                    \
             QUEUE_NEW_TYPE(unsigned char, UCHAR)    \
@@ -33,6 +34,7 @@ struct Queue;
 {
     QUEUE_FIFO = 0, // @note FIFO is not thread and interrupt safe because an add and take action happen both on the same head variable
     QUEUE_LIFO, // @note LIFO is not thread and interrupt safe because an add and take action happen both on the same head variable
+    QUEUE_SPSC, // FIFO for a single producer and a single consumer, e.g. an interrupt and the main loop, which is lock free. The length must be a power of two
             
     QUEUE_TYPE_COUNT
 };
@@ -46,6 +48,15 @@ enum QueueDataType
     QUEUE_DATA_TYPE_COUNT
 };
 
+struct QueueStatistics
+{
+    unsigned long adds;         // Elements added
+    unsigned long takes;        // Elements taken
+    unsigned long drops;        // Elements rejected because the queue was full
+    unsigned long underflows;   // Takes that found the queue empty
+    unsigned int highWater;     // Most elements queued at once
+};
+
 /**
  * Initializes the queue pool
  * @return Returns 'true' on success, otherwise 'false'
@@ -60,6 +71,7 @@ bool queue_init();
  * @param type The type of the queue
  * @param dataType The data type of the queue
  * @return Returns a pointer to the created queue or 'NULL' when an error occured
+ * @note A FIFO or LIFO queue holds 'length - 1' elements, a SPSC queue holds 'length' elements
  * @warning Make sure the buffer pointer is of the same datatype as the chosen QueueDataType
  */
 struct Queue* queue_create(void* buffer, const unsigned int length, const enum QueueType type, const enum QueueDataType dataType);
@@ -89,9 +101,68 @@ unsigned char queue_add(struct Queue* queue, const void* data);
  */
 unsigned char queue_take(struct Queue* queue, void* data);
 
+/**
+ * Add a span of data to a queue, as much as fits
+ * @param queue The queue where the data will be inserted
+ * @param data An array holding the data to be added
+ * @param count The number of elements in the array
+ * @return Returns the number of elements added
+ * @note The data is copied as at most two contiguous blocks, one up to the end of the buffer and one from its start
+ * @warning Make sure the data is of the same datatype as the Queue's QueueDataType
+ */
+unsigned int queue_add_n(struct Queue* queue, const void* data, const unsigned int count);
+
+/**
+ * Take a span of data out of the queue, as much as is available
+ * @param queue The queue where the data will be taken out
+ * @param data An array receiving the data
+ * @param count The maximum number of elements to take
+ * @return Returns the number of elements taken
+ * @note The data is copied as at most two contiguous blocks, a LIFO queue is taken element by element
+ * @warning Make sure the data is of the same datatype as the Queue's QueueDataType
+ */
+unsigned int queue_take_n(struct Queue* queue, void* data, const unsigned int count);
+
+/**
+ * Reserves a contiguous region at the head of a queue, so data can be produced in place
+ * @param queue The queue to produce in
+ * @param count The number of elements requested
+ * @param reserved Is set to the number of elements in the region, which is less than requested when the queue is
+ *                 almost full or the region reaches the end of the buffer
+ * @return Returns a pointer to the first element of the region or 'NULL' when nothing can be reserved
+ * @note The elements are only added by queue_commit(), reserving again returns the same region
+ */
+void* queue_reserve(struct Queue* queue, const unsigned int count, unsigned int* reserved);
+
+/**
+ * Adds elements produced in a region returned by queue_reserve()
+ * @param queue The queue to commit to
+ * @param count The number of elements to add, at most the number reserved
+ * @return Returns the number of elements added, which is limited to the free space and 0 for an unassigned queue
+ */
+unsigned int queue_commit(struct Queue* queue, const unsigned int count);
+
+/**
+ * Gets the contiguous region of elements at the tail of a queue, so data can be consumed in place
+ * @param queue The queue to consume from
+ * @param count Is set to the number of elements in the region, the remainder follows from the start of the buffer
+ * @return Returns a pointer to the oldest element or 'NULL' when the queue is empty
+ * @note Not available for LIFO queues, the elements are only removed by queue_consume()
+ */
+const void* queue_peek_span(const struct Queue* queue, unsigned int* count);
+
+/**
+ * Removes elements consumed in a region returned by queue_peek_span()
+ * @param queue The queue to consume from
+ * @param count The number of elements to remove, at most the number in the region
+ * @return Returns the number of elements removed, which is limited to the stored elements and 0 for an unassigned or LIFO queue
+ */
+unsigned int queue_consume(struct Queue* queue, const unsigned int count);
+
 /**
  * Flushes the queue
  * @param queue The queue which is to be flushed
+ * @note A SPSC queue may only be flushed while neither its producer nor its consumer can access it
  */
 void queue_flush(struct Queue* queue);
 
@@ -116,5 +187,36 @@ unsigned char queue_is_full(const struct Queue* queue);
  */
 unsigned char queue_is_valid(const struct Queue* queue);
 
+#ifdef QUEUE_STATISTICS
+/**
+ * Names a queue, the name identifies it in queue_print_statistics()
+ * @param queue The queue to be named
+ * @param name The name, the string is referenced and must therefore outlive the queue
+ */
+void queue_set_name(struct Queue* queue, const char* name);
+#else
+    #define queue_set_name(queue, name)     ((void)(queue), (void)(name)) // Names are only kept for the statistics
+#endif
+
+/**
+ * Gets the statistics of a queue
+ * @param queue The queue to get the statistics of
+ * @param stats Is filled with the statistics
+ * @return Returns 'true' on success, or 'false' when QUEUE_STATISTICS is not defined or the queue is invalid
+ */
+bool queue_get_statistics(const struct Queue* queue, struct QueueStatistics* stats);
+
+/**
+ * Resets the statistics of a queue, the high-water mark restarts at the number of elements currently queued
+ * @param queue The queue to reset the statistics of
+ */
+void queue_reset_statistics(struct Queue* queue);
+
+/**
+ * Prints the statistics of all valid queues in the pool as a table
+ * @note Only available when QUEUE_STATISTICS is defined, otherwise nothing is printed
+ */
+void queue_print_statistics();
+
 #endif	/* QUEUE_H */
 
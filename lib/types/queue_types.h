@@ -1,14 +1,12 @@
 #ifndef QUEUE_TYPES_H
 #define	QUEUE_TYPES_H
 
-#include "../../peripheral/uart/uart.h"
-
 /**
  * @brief Defines the different custom Queue data types
- * @details To add a new data type use the QUEUE_NEW_TYPE macro. The first parameter should be the desired data type to be used.
+ * @details To add a new data type define QUEUE_GLOBAL_CUSTOM_TYPE_TABLE here and use the QUEUE_NEW_TYPE macro for each type,
+ *          e.g. QUEUE_NEW_TYPE(struct Frame, FRAME). The first parameter should be the desired data type to be used.
  *          The second parameter defines the name to access the data type when creating a Queue.
+ *          The type must be known to this header, a queue of a single type is better generated with QUEUE_DEFINE in typed_queue.h
  */
-#define QUEUE_GLOBAL_CUSTOM_TYPE_TABLE  \
-            QUEUE_NEW_TYPE(union UartData, UART_DATA)
 
 #endif /* QUEUE_TYPES_H */
\ No newline at end of file
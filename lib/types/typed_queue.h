@@ -0,0 +1,115 @@
+#ifndef TYPED_QUEUE_H
+#define	TYPED_QUEUE_H
+
+#include "../std/stdtypes.h"
+#include <string.h>
+
+/*
+ * Generator for statically sized queues of a single element type, as an alternative to the pool in queue.h.
+ *
+ *     QUEUE_DEFINE(FrameQueue, struct Frame, 8)
+ *     static struct FrameQueue frames = TYPED_QUEUE_INITIALIZER;
+ *
+ *     FrameQueue_add(&frames, &frame);
+ *     while(FrameQueue_take(&frames, &frame))
+ *         render(&frame);
+ *
+ * Every operation is an inline function specialized for the element type and capacity, there is no pool lookup and no
+ * dispatch on a data type. The queue is a lock free ring for a single producer and a single consumer like QUEUE_SPSC,
+ * the capacity must therefore be a power of two. It holds 'capacity' elements.
+ */
+
+#define TYPED_QUEUE_INITIALIZER     { .head = 0, .tail = 0 }
+#define TYPED_QUEUE_BARRIER()       __asm__ volatile("" ::: "memory") // The core executes in order and data memory is not cached, so only the compiler may reorder
+
+/**
+ * Defines a queue type 'struct name' and its functions 'name_init', 'name_add', 'name_take', 'name_add_n', 'name_take_n',
+ * 'name_count', 'name_is_empty' and 'name_is_full', with the same semantics as their counterparts in queue.h
+ * @param name The name of the queue type, also used as prefix of its functions
+ * @param type The element type
+ * @param capacity The number of elements, must be a power of two
+ */
+#define QUEUE_DEFINE(name, type, capacity)                                                                  \
+    typedef char name##_capacity_must_be_a_power_of_two[((capacity) > 0 && ((capacity) & ((capacity) - 1)) == 0) ? 1 : -1]; \
+                                                                                                            \
+    struct name                                                                                             \
+    {                                                                                                       \
+        type buffer[capacity];                                                                              \
+        volatile unsigned int head; /* Free running, only written by the producer */                        \
+        volatile unsigned int tail; /* Free running, only written by the consumer */                        \
+    };                                                                                                      \
+                                                                                                            \
+    static inline void name##_init(struct name* queue)                                                      \
+    {                                                                                                       \
+        queue->head = 0;                                                                                    \
+        queue->tail = 0;                                                                                    \
+    }                                                                                                       \
+                                                                                                            \
+    static inline unsigned char name##_add(struct name* queue, const type* data)                            \
+    {                                                                                                       \
+        const unsigned int head = queue->head;                                                              \
+        if(head - queue->tail >= (capacity))                                                                \
+            return 0;                                                                                       \
+        queue->buffer[head & ((capacity) - 1)] = *data;                                                     \
+        TYPED_QUEUE_BARRIER();                                                                              \
+        queue->head = head + 1;                                                                             \
+        return 1;                                                                                           \
+    }                                                                                                       \
+                                                                                                            \
+    static inline unsigned char name##_take(struct name* queue, type* data)                                 \
+    {                                                                                                       \
+        const unsigned int tail = queue->tail;                                                              \
+        if(queue->head == tail)                                                                             \
+            return 0;                                                                                       \
+        TYPED_QUEUE_BARRIER();                                                                              \
+        *data = queue->buffer[tail & ((capacity) - 1)];                                                     \
+        TYPED_QUEUE_BARRIER();                                                                              \
+        queue->tail = tail + 1;                                                                             \
+        return 1;                                                                                           \
+    }                                                                                                       \
+                                                                                                            \
+    static inline unsigned int name##_add_n(struct name* queue, const type* data, const unsigned int count) \
+    {                                                                                                       \
+        const unsigned int head = queue->head;                                                              \
+        const unsigned int space = (capacity) - (head - queue->tail);                                       \
+        const unsigned int n = (count < space) ? count : space;                                             \
+        const unsigned int index = head & ((capacity) - 1);                                                 \
+        const unsigned int first = (n < (capacity) - index) ? n : ((capacity) - index);                     \
+        memcpy(&queue->buffer[index], data, first * sizeof(type));                                          \
+        memcpy(queue->buffer, data + first, (n - first) * sizeof(type));                                    \
+        TYPED_QUEUE_BARRIER();                                                                              \
+        queue->head = head + n;                                                                             \
+        return n;                                                                                           \
+    }                                                                                                       \
+                                                                                                            \
+    static inline unsigned int name##_take_n(struct name* queue, type* data, const unsigned int count)      \
+    {                                                                                                       \
+        const unsigned int tail = queue->tail;                                                              \
+        const unsigned int used = queue->head - tail;                                                       \
+        const unsigned int n = (count < used) ? count : used;                                               \
+        const unsigned int index = tail & ((capacity) - 1);                                                 \
+        const unsigned int first = (n < (capacity) - index) ? n : ((capacity) - index);                     \
+        TYPED_QUEUE_BARRIER();                                                                              \
+        memcpy(data, &queue->buffer[index], first * sizeof(type));                                          \
+        memcpy(data + first, queue->buffer, (n - first) * sizeof(type));                                    \
+        TYPED_QUEUE_BARRIER();                                                                              \
+        queue->tail = tail + n;                                                                             \
+        return n;                                                                                           \
+    }                                                                                                       \
+                                                                                                            \
+    static inline unsigned int name##_count(const struct name* queue)                                       \
+    {                                                                                                       \
+        return queue->head - queue->tail;                                                                   \
+    }                                                                                                       \
+                                                                                                            \
+    static inline unsigned char name##_is_empty(const struct name* queue)                                   \
+    {                                                                                                       \
+        return (queue->head == queue->tail);                                                                \
+    }                                                                                                       \
+                                                                                                            \
+    static inline unsigned char name##_is_full(const struct name* queue)                                    \
+    {                                                                                                       \
+        return (queue->head - queue->tail >= (capacity));                                                   \
+    }
+
+#endif	/* TYPED_QUEUE_H */
@@ -1,5 +1,7 @@
 #include "kernel/scheduler/scheduler.h"
 #include "kernel/utils/timer/timer.h"
+#include "kernel/utils/hrtimer/hrtimer.h"
+#include "kernel/utils/alarm/alarm.h"
 #include "lib/types/queue.h"
 #include "lib/print/print.h"
 #include "peripheral/system/cfg/config.h"
@@ -7,6 +9,7 @@
 #include "peripheral/uart/uart.h"
 #include "peripheral/uart/stream/uart_stream.h"
 #include "peripheral/spi/spi.h"
+#include "peripheral/rtcc/rtcc.h"
 #include "lib/std/stdtypes.h"
 #include <xc.h>
 
@@ -24,9 +27,14 @@ static struct Module modules[] =
     { config_cpu_init },
     { scheduler_init },
     { timer_init },
+#ifdef HRTIMER_ENABLED
+    { hrtimer_init },
+#endif
     { queue_init },
     { uart_init },
     { spi_init },
+    { rtcc_init },
+    { alarm_init },
     { NULL } // Terminator
 };
 
@@ -69,7 +77,10 @@ bool initialize_modules()
 
 void scheduler_populate()
 {
-    
+    // Fixed periodic work belongs in the static event table, SCHEDULER_STATIC_EVENTS in scheduler_config.h
+#if defined(SCHEDULER_LOAD_METER) && defined(SCHEDULER_LOAD_REPORT_S)
+    scheduler_create_event(scheduler_print_load, SCHEDULER_LOAD_REPORT_S, SCHEDULER_UNIT_S, PRIO_LOW);
+#endif
 }
 void halt_processor()
 {
@@ -0,0 +1,7 @@
+#ifndef RTCC_CONFIG_H
+#define	RTCC_CONFIG_H
+
+#define RTCC_INTERRUPT_PRIORITY     INTERRUPT_PRIORITY_2
+#define RTCC_INTERRUPT_IPL          IPL2AUTO    // Must match the interrupt priority
+
+#endif	/* RTCC_CONFIG_H */
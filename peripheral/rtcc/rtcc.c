@@ -0,0 +1,196 @@
+#include "rtcc.h"
+#include "../interrupt/interrupt.h"
+#include "../system/sys/sys.h"
+#include "../../kernel/scheduler/scheduler.h"
+#include <xc.h>
+#include <sys/attribs.h>
+#include <stddef.h>
+
+#ifndef _RTCC
+    #error "The RTCC is not available on this device"
+#endif
+
+#define RTCC_FIRST_YEAR         2000
+#define RTCC_LAST_YEAR          2099
+#define RTCC_ALARM_ONCE_A_YEAR  0x09 // Alarm mask, matches on month, day, hours, minutes and seconds
+
+#define toBcd(value)            ((unsigned long)((((value) / 10) << 4) | ((value) % 10)))
+#define fromBcd(value)          ((unsigned char)((((value) >> 4) & 0x0F) * 10 + ((value) & 0x0F)))
+#define isLeapYear(year)        (((year) & 0x03) == 0) // Holds for every year within the calendar range
+
+static void rtcc_write_enable(const bool enable);
+static unsigned long rtcc_encode_time(const struct RtccTime* time);
+static unsigned long rtcc_encode_date(const struct RtccTime* time);
+static unsigned char days_in_month(const unsigned short year, const unsigned char month);
+
+static const unsigned short daysBeforeMonth[12] = { 0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334 };
+static const unsigned char daysPerMonth[12] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+static volatile RtccAlarmHandle alarmHandle = NULL;
+
+bool rtcc_init()
+{
+    rtcc_cancel_alarm();
+    interrupt_clr_flag(INTERRUPT_REAL_TIME_CLOCK);
+    interrupt_enable(INTERRUPT_REAL_TIME_CLOCK, RTCC_INTERRUPT_PRIORITY);
+    
+    // The calendar is left untouched, so the time survives a reset
+    rtcc_write_enable(true);
+    RTCCONbits.RTCOE = 0; // No clock output
+    RTCCONbits.ON = 1;
+    rtcc_write_enable(false);
+    return true;
+}
+
+bool rtcc_set_time(const struct RtccTime* time)
+{
+    struct RtccTime normalized;
+    
+    if(time == NULL || time->year < RTCC_FIRST_YEAR || time->year > RTCC_LAST_YEAR || time->month < 1 || time->month > 12 ||
+            time->day < 1 || time->day > days_in_month(time->year, time->month) || time->hour > 23 || time->minute > 59 || time->second > 59)
+        return false;
+    
+    rtcc_from_seconds(rtcc_to_seconds(time), &normalized); // Derives the weekday
+    
+    rtcc_write_enable(true);
+    RTCCONbits.ON = 0;
+    while(RTCCONbits.RTCCLKON); // Wait for the clock to stop, so the registers can not roll over while being written
+    RTCTIME = rtcc_encode_time(&normalized);
+    RTCDATE = rtcc_encode_date(&normalized);
+    RTCCONbits.ON = 1;
+    rtcc_write_enable(false);
+    return true;
+}
+
+void rtcc_get_time(struct RtccTime* time)
+{
+    unsigned long rtcTime, rtcDate;
+    
+    // The date only changes when the time rolls over, so a stable time guarantees a matching date
+    do {
+        rtcTime = RTCTIME;
+        rtcDate = RTCDATE;
+    } while(rtcTime != RTCTIME);
+    
+    time->year = RTCC_FIRST_YEAR + fromBcd(rtcDate >> 24);
+    time->month = fromBcd((rtcDate >> 16) & 0x1F);
+    time->day = fromBcd((rtcDate >> 8) & 0x3F);
+    time->weekday = rtcDate & 0x07;
+    time->hour = fromBcd((rtcTime >> 24) & 0x3F);
+    time->minute = fromBcd((rtcTime >> 16) & 0x7F);
+    time->second = fromBcd((rtcTime >> 8) & 0x7F);
+}
+
+unsigned long rtcc_get_seconds()
+{
+    struct RtccTime time;
+    rtcc_get_time(&time);
+    return rtcc_to_seconds(&time);
+}
+
+unsigned char rtcc_is_running()
+{
+    return RTCCONbits.RTCCLKON;
+}
+
+bool rtcc_set_alarm(const unsigned long seconds, const RtccAlarmHandle handle)
+{
+    struct RtccTime time;
+    const unsigned long now = rtcc_get_seconds();
+    
+    if(handle == NULL || seconds <= now || seconds - now > RTCC_ALARM_MAX_AHEAD)
+        return false;
+    
+    rtcc_cancel_alarm();
+    rtcc_from_seconds(seconds, &time);
+    ALRMTIME = rtcc_encode_time(&time);
+    ALRMDATE = rtcc_encode_date(&time) & 0x00FFFFFF; // The alarm has no year
+    alarmHandle = handle;
+    RTCALRMbits.CHIME = 0; // Disarm once the alarm matched
+    RTCALRMbits.ARPT = 0;
+    RTCALRMbits.AMASK = RTCC_ALARM_ONCE_A_YEAR;
+    RTCALRMbits.ALRMEN = 1;
+    return true;
+}
+
+void rtcc_cancel_alarm()
+{
+    alarmHandle = NULL; // An alarm matching from here on is ignored by the interrupt
+    while(RTCALRMbits.ALRMSYNC); // The alarm registers must not be written while they synchronize with the clock
+    RTCALRMbits.ALRMEN = 0;
+    interrupt_clr_flag(INTERRUPT_REAL_TIME_CLOCK);
+}
+
+unsigned long rtcc_to_seconds(const struct RtccTime* time)
+{
+    const unsigned long years = time->year - RTCC_FIRST_YEAR;
+    unsigned long days = years * 365 + (years + 3) / 4; // Every fourth year starting at 2000 is a leap year
+    
+    days += daysBeforeMonth[time->month - 1] + (time->day - 1);
+    if(time->month > 2 && isLeapYear(time->year))
+        days++;
+    return days * RTCC_SECONDS_PER_DAY + time->hour * 3600LU + time->minute * 60LU + time->second;
+}
+
+void rtcc_from_seconds(const unsigned long seconds, struct RtccTime* time)
+{
+    unsigned long days = seconds / RTCC_SECONDS_PER_DAY;
+    const unsigned long remainder = seconds % RTCC_SECONDS_PER_DAY;
+    unsigned short year = RTCC_FIRST_YEAR;
+    unsigned char month = 1;
+    
+    time->hour = remainder / 3600;
+    time->minute = (remainder / 60) % 60;
+    time->second = remainder % 60;
+    time->weekday = (days + RTCC_EPOCH_WEEKDAY) % RTCC_WEEKDAY_COUNT;
+    
+    while(days >= (isLeapYear(year) ? 366 : 365)) {
+        days -= isLeapYear(year) ? 366 : 365;
+        year++;
+    }
+    while(days >= days_in_month(year, month)) {
+        days -= days_in_month(year, month);
+        month++;
+    }
+    time->year = year;
+    time->month = month;
+    time->day = days + 1;
+}
+
+void __ISR(_RTCC_VECTOR, RTCC_INTERRUPT_IPL) rtcc_interrupt(void)
+{
+    SCHEDULER_ISR_ENTER();
+    
+    // The alarm is one-shot, the handle may arm the next one
+    const RtccAlarmHandle handle = alarmHandle;
+    alarmHandle = NULL;
+    interrupt_clr_flag(INTERRUPT_REAL_TIME_CLOCK);
+    if(handle != NULL)
+        (*handle)();
+    
+    SCHEDULER_ISR_EXIT();
+}
+
+void rtcc_write_enable(const bool enable)
+{
+    // The unlock sequence must not be interrupted
+    const unsigned long status = __builtin_disable_interrupts();
+    sys_unlock();
+    RTCCONbits.RTCWREN = enable;
+    sys_lock();
+    _CP0_SET_STATUS(status);
+}
+
+unsigned long rtcc_encode_time(const struct RtccTime* time)
+{
+    return (toBcd(time->hour) << 24) | (toBcd(time->minute) << 16) | (toBcd(time->second) << 8);
+}
+
+unsigned long rtcc_encode_date(const struct RtccTime* time)
+{
+    return (toBcd(time->year - RTCC_FIRST_YEAR) << 24) | (toBcd(time->month) << 16) | (toBcd(time->day) << 8) | time->weekday;
+}
+
+unsigned char days_in_month(const unsigned short year, const unsigned char month)
+{
+    return (month == 2 && isLeapYear(year)) ? 29 : daysPerMonth[month - 1];
+}
@@ -0,0 +1,103 @@
+#ifndef RTCC_H
+#define	RTCC_H
+
+#include "cfg/rtcc_config.h"
+#include "../../lib/std/stdtypes.h"
+
+/*
+ * Real-time clock and calendar, clocked by the 32.768 kHz secondary oscillator.
+ * The calendar covers the years 2000 up to 2099, times can also be expressed in seconds since 2000-01-01 00:00:00.
+ * A single one-shot alarm is available, its handle is executed from the RTCC interrupt.
+ */
+
+#define RTCC_SECONDS_PER_DAY    86400LU
+#define RTCC_EPOCH_WEEKDAY      RTCC_SATURDAY // Weekday of 2000-01-01
+#define RTCC_ALARM_MAX_AHEAD    (364LU * RTCC_SECONDS_PER_DAY) // The alarm matches on month, day and time, so it must lie within a year
+
+enum RtccWeekday
+{
+    RTCC_SUNDAY = 0,
+    RTCC_MONDAY,
+    RTCC_TUESDAY,
+    RTCC_WEDNESDAY,
+    RTCC_THURSDAY,
+    RTCC_FRIDAY,
+    RTCC_SATURDAY,
+    
+    RTCC_WEEKDAY_COUNT
+};
+
+struct RtccTime
+{
+    unsigned short year;    // 2000 up to 2099
+    unsigned char month;    // 1 up to 12
+    unsigned char day;      // 1 up to 31
+    unsigned char weekday;  // See RtccWeekday, derived from the date when the time is set
+    unsigned char hour;     // 0 up to 23
+    unsigned char minute;   // 0 up to 59
+    unsigned char second;   // 0 up to 59
+};
+
+typedef void (*RtccAlarmHandle)();
+
+/**
+ * Initializes the RTCC, the calendar keeps running when it was already running
+ * @return Returns 'true' on success, otherwise 'false'
+ * @note The secondary oscillator must be enabled, it may take up to a second before the clock starts counting
+ */
+bool rtcc_init();
+
+/**
+ * Sets the time and date of the RTCC, the weekday is derived from the date
+ * @param time The new time and date
+ * @return Returns 'true' on success, or 'false' when the time or date is invalid
+ */
+bool rtcc_set_time(const struct RtccTime* time);
+
+/**
+ * Gets the current time and date of the RTCC
+ * @param time Is filled with the current time and date
+ */
+void rtcc_get_time(struct RtccTime* time);
+
+/**
+ * Gets the current time in seconds since 2000-01-01 00:00:00
+ * @return Returns the number of seconds
+ */
+unsigned long rtcc_get_seconds();
+
+/**
+ * Checks if the RTCC clock is running
+ * @return Returns '1' when the secondary oscillator clocks the RTCC, otherwise '0'
+ */
+unsigned char rtcc_is_running();
+
+/**
+ * Arms the one-shot alarm, a previously armed alarm is replaced
+ * @param seconds The time of the alarm in seconds since 2000-01-01 00:00:00
+ * @param handle The handle executed from the RTCC interrupt once the alarm matches
+ * @return Returns 'true' on success, or 'false' when the alarm does not lie in the future within RTCC_ALARM_MAX_AHEAD
+ * @note The alarm matches the moment the clock reaches the given second, it wakes the processor from idle and sleep mode
+ */
+bool rtcc_set_alarm(const unsigned long seconds, const RtccAlarmHandle handle);
+
+/**
+ * Disarms the alarm, its handle will not be executed
+ */
+void rtcc_cancel_alarm();
+
+/**
+ * Converts a time and date to seconds since 2000-01-01 00:00:00
+ * @param time The time and date to convert, the weekday is ignored
+ * @return Returns the number of seconds
+ */
+unsigned long rtcc_to_seconds(const struct RtccTime* time);
+
+/**
+ * Converts seconds since 2000-01-01 00:00:00 to a time and date
+ * @param seconds The number of seconds
+ * @param time Is filled with the time and date, including the weekday
+ */
+void rtcc_from_seconds(const unsigned long seconds, struct RtccTime* time);
+
+#endif	/* RTCC_H */
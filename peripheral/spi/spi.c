@@ -3,6 +3,7 @@
 #include "../interrupt/interrupt.h"
 #include "../../lib/types/queue.h"
 #include "../../lib/print/assert.h"
+#include "../../kernel/scheduler/scheduler.h"
 
 #define SPI_SS_EN_BIT           BIT_SHIFT(7)
 #define SPI_SDI_DIS_BIT         BIT_SHIFT(4)
@@ -15,6 +16,7 @@ struct SpiModule
 {
     struct Queue* rxFifo;
     struct Queue* txFifo;
+    SpiReceiveHandle receiveHandle;
     enum SpiChannel channel;
     unsigned char error;
     struct {
@@ -75,6 +77,18 @@ static const enum InterruptRequest spiInterruptTable[] =
 #endif
 };
 
+#ifdef QUEUE_STATISTICS
+static const char* const spiQueueNames[][2] =
+{
+#if defined(_SPI1) && !defined(SPI_CHANNEL1_FORCE_DISABLE)
+    { "SPI1 RX", "SPI1 TX" },
+#endif
+#if defined(_SPI2) && !defined(SPI_CHANNEL2_FORCE_DISABLE)
+    { "SPI2 RX", "SPI2 TX" },
+#endif
+};
+#endif
+
 static struct SpiModule spiModulePool[SPI_CHANNEL_COUNT];
 static const size_t nSpiModules = SPI_CHANNEL_COUNT;
 
@@ -94,11 +108,18 @@ struct SpiModule* spi_create(const enum SpiChannel channel, unsigned int* rxBuff
     struct SpiModule* module = NULL;
     if(channel >= SPI_CHANNEL_COUNT || rxBuffer == NULL || txBuffer == NULL || rxSize == 0 || txSize == 0)      
         return module;
+    if((rxSize & (rxSize - 1)) != 0 || (txSize & (txSize - 1)) != 0)
+        return module; // The queues are lock free rings, see QUEUE_SPSC
     
     module = &spiModulePool[channel];
     if(!module->opt.assigned) { // Unused module was found
-        module->rxFifo = queue_create(rxBuffer, rxSize, QUEUE_FIFO, QUEUE_UINT);
-        module->txFifo = queue_create(txBuffer, txSize, QUEUE_FIFO, QUEUE_UINT);
+        module->rxFifo = queue_create(rxBuffer, rxSize, QUEUE_SPSC, QUEUE_UINT);
+        module->txFifo = queue_create(txBuffer, txSize, QUEUE_SPSC, QUEUE_UINT);
+#ifdef QUEUE_STATISTICS
+        queue_set_name(module->rxFifo, spiQueueNames[channel][0]);
+        queue_set_name(module->txFifo, spiQueueNames[channel][1]);
+#endif
+        module->receiveHandle = NULL;
         module->channel = channel;
         module->error = SPI_ERROR_OK;
         module->opt.assigned = 1;
@@ -120,6 +141,14 @@ void spi_invalidate(struct SpiModule* module)
     }
 }
 
+void spi_set_receive_handle(struct SpiModule* module, const SpiReceiveHandle handle)
+{
+    if(module == NULL)
+        return;
+    
+    module->receiveHandle = handle;
+}
+
 void spi_configure(const struct SpiModule* module, const enum SpiConfiguration mask)
 {
     if(module == NULL)
@@ -279,12 +308,8 @@ unsigned int spi_transmit(const struct SpiModule* module, const unsigned int* bu
     if(!module->opt.assigned || module->error)
         return rSize;
     
-    spi_disable_interrupt(module->channel, SPI_INTERRUPT_TRANSFER_DONE); // @Todo: review if this is really necessary
-    while(!queue_is_full(module->txFifo) && rSize < size) {
-        queue_add(module->txFifo, &buffer[rSize]);
-        rSize++;
-    }
-    spi_enable_interrupt(module->channel, SPI_INTERRUPT_TRANSFER_DONE);
+    rSize = queue_add_n(module->txFifo, buffer, size);
+    spi_enable_interrupt(module->channel, SPI_INTERRUPT_TRANSFER_DONE); // Restarts the transmission, the interrupt disables itself once the queue is empty
     return rSize;
 }
 
@@ -297,10 +322,7 @@ unsigned int spi_receive(const struct SpiModule* module, unsigned int* buffer, c
     if(!module->opt.assigned || module->error)
         return rSize;
     
-    spi_disable_interrupt(module->channel, SPI_INTERRUPT_RECEIVE_DONE);  // @Todo: review if this is really necessary
-    while(!queue_is_empty(module->rxFifo) && rSize < size)
-        queue_take(module->rxFifo, &buffer[rSize++]);
-    spi_enable_interrupt(module->channel, SPI_INTERRUPT_RECEIVE_DONE);  // @Todo: review if this is really necessary
+    rSize = queue_take_n(module->rxFifo, buffer, size);
     return rSize;
 }
 
@@ -356,6 +378,8 @@ void spi_clr_interrupt_flag(const enum SpiChannel channel, enum InterruptEnable
 #if defined(_SPI1) && !defined(SPI_CHANNEL1_FORCE_DISABLE)
 void __ISR(_SPI_1_VECTOR, IPL7AUTO)SPI1interrupt(void)
 {
+    SCHEDULER_ISR_ENTER();
+    
     // Ignore NULL checks for performance
     struct SpiModule* module = &spiModulePool[SPI_CHANNEL1];
     const struct SpiMap* spiMap = &spiMappingTable[SPI_CHANNEL1];
@@ -379,6 +403,8 @@ void __ISR(_SPI_1_VECTOR, IPL7AUTO)SPI1interrupt(void)
     } else {
         if(interrupt_get_flag(INTERRUPT_SPI1_RECEIVE_DONE)) {
             queue_add(module->rxFifo, (unsigned int*)&spiSfr->spibuf);
+            if(module->receiveHandle != NULL)
+                (*module->receiveHandle)(module);
             interrupt_clr_flag(INTERRUPT_SPI1_RECEIVE_DONE);
         }
         if(interrupt_get_flag(INTERRUPT_SPI1_TRANSMIT_DONE)) {
@@ -388,12 +414,16 @@ void __ISR(_SPI_1_VECTOR, IPL7AUTO)SPI1interrupt(void)
             interrupt_clr_flag(INTERRUPT_SPI1_TRANSMIT_DONE);
         }
     }
+    
+    SCHEDULER_ISR_EXIT();
 }
 #endif
 
 #if defined(_SPI2) && !defined(SPI_CHANNEL2_FORCE_DISABLE)
 void __ISR(_SPI_2_VECTOR, IPL7AUTO)SPI2interrupt(void)
 {
+    SCHEDULER_ISR_ENTER();
+    
     // Ignore NULL checks for performance
     struct SpiModule* module = &spiModulePool[SPI_CHANNEL2];
     const struct SpiMap* spiMap = &spiMappingTable[SPI_CHANNEL2];
@@ -417,6 +447,8 @@ void __ISR(_SPI_2_VECTOR, IPL7AUTO)SPI2interrupt(void)
     } else {
         if(interrupt_get_flag(INTERRUPT_SPI2_RECEIVE_DONE)) {
             queue_add(module->rxFifo, (unsigned int*)&spiSfr->spibuf);
+            if(module->receiveHandle != NULL)
+                (*module->receiveHandle)(module);
             interrupt_clr_flag(INTERRUPT_SPI2_RECEIVE_DONE);
         }
         if(interrupt_get_flag(INTERRUPT_SPI2_TRANSMIT_DONE)) {
@@ -426,5 +458,7 @@ void __ISR(_SPI_2_VECTOR, IPL7AUTO)SPI2interrupt(void)
             interrupt_clr_flag(INTERRUPT_SPI2_TRANSMIT_DONE);
         }
     }
+    
+    SCHEDULER_ISR_EXIT();
 }
 #endif
\ No newline at end of file
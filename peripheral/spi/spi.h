@@ -20,6 +20,7 @@ enum SpiChannel {
 };
 
 struct SpiModule;
+typedef void (*SpiReceiveHandle)(struct SpiModule* module);
 
 enum SpiConfiguration
 {
@@ -109,8 +110,8 @@ bool spi_init();
  * @param channel The channel to be used
  * @param rxBuffer A uint array that will be used as RX FIFO queue
  * @param txBuffer A uint array that will be used as TX FIFO queue
- * @param rxSize The size of the RX uint array
- * @param txSize The size of the TX uint array
+ * @param rxSize The size of the RX uint array, must be a power of two
+ * @param txSize The size of the TX uint array, must be a power of two
  * @return Returns a pointer to the created SPI module
  */
 struct SpiModule* spi_create(const enum SpiChannel channel, unsigned int* rxBuffer, unsigned int* txBuffer, const unsigned int rxSize, const unsigned int txSize);
@@ -121,6 +122,14 @@ struct SpiModule* spi_create(const enum SpiChannel channel, unsigned int* rxBuff
  */
 void spi_invalidate(struct SpiModule* module);
 
+/**
+ * Sets a handle that is executed each time data was received
+ * @param module The module to be changed
+ * @param handle The handle to execute, or 'NULL' to remove the current handle
+ * @note The handle is executed from within the interrupt, use 'scheduler_post' to defer the actual processing
+ */
+void spi_set_receive_handle(struct SpiModule* module, const SpiReceiveHandle handle);
+
 /**
  * Configures the SPI module
  * @param module The module to be configured
@@ -19,7 +19,7 @@ bool oscillator_init()
     OSCCONbits.CLKLOCK = 1; // Lock clock and PLL selections
     OSCCONbits.SLPEN = 0; // Enter idle mode upon WAIT instruction
     OSCCONbits.UFRCEN = 0; // Use primary oscillator or USB PLL as USB clock source
-    OSCCONbits.SOSCEN = 0; // Disable secondary oscillator
+    OSCCONbits.SOSCEN = 1; // Enable secondary oscillator, clocks the RTCC
     
     OSCTUNbits.TUN = 0; // Calibrated frequency
     sys_lock();
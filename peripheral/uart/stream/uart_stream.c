@@ -17,7 +17,7 @@ struct PrintStream uart_stream =
 };
 
 union UartData rxBuffer[1]; // @Todo: we should be able to create a module without a RX or TX buffer, we then should prohibit to enable the RX or TX
-union UartData txBuffer[255];
+union UartData txBuffer[256];
 
 void uart_stream_open()
 {
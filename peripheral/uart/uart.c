@@ -3,6 +3,7 @@
 #include "../interrupt/interrupt.h"
 #include "../../lib/types/queue.h"
 #include "../../lib/print/assert.h"
+#include "../../kernel/scheduler/scheduler.h"
 
 #define UART_RX_EN_BIT          BIT_SHIFT(12)
 #define UART_TX_EN_BIT          BIT_SHIFT(10)
@@ -11,10 +12,13 @@
 
 #define uartAutoAddressMask(x)  ((reg_t)x << 16)
 
+typedef char uart_data_must_fit_a_ushort[(sizeof(union UartData) == sizeof(unsigned short)) ? 1 : -1]; // The queues store UartData as QUEUE_USHORT
+
 struct UartModule
 {
     struct Queue* rxFifo;
     struct Queue* txFifo;
+    UartReceiveHandle receiveHandle;
     enum UartChannel channel;
     enum UartError error;
     struct {
@@ -83,6 +87,30 @@ static const enum InterruptRequest uartInterruptTable[] =
 #endif
 };
 
+#ifdef QUEUE_STATISTICS
+static const char* const uartQueueNames[][2] =
+{
+#if defined(_UART1) && !defined(UART_CHANNEL1_FORCE_DISABLE)
+    { "UART1 RX", "UART1 TX" },
+#endif
+#if defined(_UART2) && !defined(UART_CHANNEL2_FORCE_DISABLE)
+    { "UART2 RX", "UART2 TX" },
+#endif
+#if defined(_UART3) && !defined(UART_CHANNEL3_FORCE_DISABLE)
+    { "UART3 RX", "UART3 TX" },
+#endif
+#if defined(_UART4) && !defined(UART_CHANNEL4_FORCE_DISABLE)
+    { "UART4 RX", "UART4 TX" },
+#endif
+#if defined(_UART5) && !defined(UART_CHANNEL5_FORCE_DISABLE)
+    { "UART5 RX", "UART5 TX" },
+#endif
+#if defined(_UART6) && !defined(UART_CHANNEL6_FORCE_DISABLE)
+    { "UART6 RX", "UART6 TX" },
+#endif
+};
+#endif
+
 static struct UartModule uartModulePool[UART_CHANNEL_COUNT];
 static const size_t nUartModules = UART_CHANNEL_COUNT;
 
@@ -102,11 +130,18 @@ struct UartModule* uart_create(const enum UartChannel channel, union UartData* r
     struct UartModule* module = NULL;
     if(channel >= UART_CHANNEL_COUNT || rxBuffer == NULL || txBuffer == NULL || rxSize == 0 || txSize == 0)      
         return module;
+    if((rxSize & (rxSize - 1)) != 0 || (txSize & (txSize - 1)) != 0)
+        return module; // The queues are lock free rings, see QUEUE_SPSC
     
     module = &uartModulePool[channel];
     if(!module->opt.assigned) { // Unused module was found
-        module->rxFifo = queue_create(rxBuffer, rxSize, QUEUE_FIFO, QUEUE_UART_DATA);
-        module->txFifo = queue_create(txBuffer, txSize, QUEUE_FIFO, QUEUE_UART_DATA);
+        module->rxFifo = queue_create(rxBuffer, rxSize, QUEUE_SPSC, QUEUE_USHORT); // UartData is stored as its 16 bit register value
+        module->txFifo = queue_create(txBuffer, txSize, QUEUE_SPSC, QUEUE_USHORT);
+#ifdef QUEUE_STATISTICS
+        queue_set_name(module->rxFifo, uartQueueNames[channel][0]);
+        queue_set_name(module->txFifo, uartQueueNames[channel][1]);
+#endif
+        module->receiveHandle = NULL;
         module->channel = channel;
         module->error = UART_ERROR_OK;
         module->opt.assigned = 1;
@@ -128,6 +163,14 @@ void uart_invalidate(struct UartModule* module)
     }
 }
 
+void uart_set_receive_handle(struct UartModule* module, const UartReceiveHandle handle)
+{
+    if(module == NULL)
+        return;
+    
+    module->receiveHandle = handle;
+}
+
 void uart_configure(const struct UartModule* module, const enum UartConfiguration mask)
 {
     if(module == NULL)
@@ -331,10 +374,8 @@ unsigned int uart_transmit(const struct UartModule* module, const union UartData
     if(!module->opt.assigned || module->error)
         return rLength;
     
-    uart_disable_interrupt(module->channel, UART_INTERRUPT_TRANSFER_DONE); // @Todo: review if this is really necessary
-    while(!queue_is_full(module->txFifo) && rLength < length)
-        queue_add(module->txFifo, &data[rLength++]);
-    uart_enable_interrupt(module->channel, UART_INTERRUPT_TRANSFER_DONE);
+    rLength = queue_add_n(module->txFifo, data, length);
+    uart_enable_interrupt(module->channel, UART_INTERRUPT_TRANSFER_DONE); // Restarts the transmission, the interrupt disables itself once the queue is empty
     return rLength;
 }
 
@@ -347,10 +388,7 @@ unsigned int uart_receive(const struct UartModule* module, union UartData* data,
     if(!module->opt.assigned || module->error)
         return rLength;
     
-    uart_disable_interrupt(module->channel, UART_INTERRUPT_RECEIVE_DONE);  // @Todo: review if this is really necessary
-    while(!queue_is_empty(module->rxFifo) && rLength < length)
-        queue_take(module->rxFifo, &data[rLength++]);
-    uart_enable_interrupt(module->channel, UART_INTERRUPT_RECEIVE_DONE);  // @Todo: review if this is really necessary
+    rLength = queue_take_n(module->rxFifo, data, length);
     return rLength;
 }
 
@@ -363,14 +401,18 @@ unsigned int uart_transmit_raw(const struct UartModule* module, const void* buff
     if(!module->opt.assigned || module->error)
         return rSize;
     
+    // Bytes are widened to UartData in place, in at most two regions of the queue
     const unsigned char* rawBuffer = (const unsigned char*)buffer;
-    union UartData tx = { 0 };
-    uart_disable_interrupt(module->channel, UART_INTERRUPT_TRANSFER_DONE); // @Todo: review if this is really necessary
-    while(!queue_is_full(module->txFifo) && rSize < size) {
-        tx.data = rawBuffer[rSize++];
-        queue_add(module->txFifo, &tx);
+    union UartData* tx;
+    unsigned int i, reserved;
+    while(rSize < size && (tx = queue_reserve(module->txFifo, size - rSize, &reserved)) != NULL) {
+        for(i = 0; i < reserved; ++i) {
+            tx[i]._reg = 0;
+            tx[i].data = rawBuffer[rSize++];
+        }
+        queue_commit(module->txFifo, reserved);
     }
-    uart_enable_interrupt(module->channel, UART_INTERRUPT_TRANSFER_DONE);
+    uart_enable_interrupt(module->channel, UART_INTERRUPT_TRANSFER_DONE); // Restarts the transmission, the interrupt disables itself once the queue is empty
     return rSize;
 }
 
@@ -383,13 +425,16 @@ unsigned int uart_receive_raw(const struct UartModule* module, unsigned char* bu
     if(!module->opt.assigned || module->error)
         return rSize;
     
-    union UartData rx = { 0 };
-    uart_disable_interrupt(module->channel, UART_INTERRUPT_RECEIVE_DONE);  // @Todo: review if this is really necessary
-    while(!queue_is_empty(module->rxFifo) && rSize < size) {
-        queue_take(module->rxFifo, &rx);
-        buffer[rSize++] = rx.data;
+    // Data is narrowed to bytes in place, from at most two regions of the queue
+    const union UartData* rx;
+    unsigned int i, available;
+    while(rSize < size && (rx = queue_peek_span(module->rxFifo, &available)) != NULL) {
+        if(available > size - rSize)
+            available = size - rSize;
+        for(i = 0; i < available; ++i)
+            buffer[rSize++] = rx[i].data;
+        queue_consume(module->rxFifo, available);
     }
-    uart_enable_interrupt(module->channel, UART_INTERRUPT_RECEIVE_DONE);  // @Todo: review if this is really necessary
     return rSize;
 }
 
@@ -456,6 +501,8 @@ void uart_clr_interrupt_flag(const enum UartChannel channel, enum InterruptEnabl
 #if defined(_UART1) && !defined(UART_CHANNEL1_FORCE_DISABLE)
 void __ISR(_UART_1_VECTOR, IPL7AUTO)UART1interrupt(void)
 {
+    SCHEDULER_ISR_ENTER();
+    
     // Ignore NULL checks for performance
     struct UartModule* module = &uartModulePool[UART_CHANNEL1];
     const struct UartMap* uartMap = &uartMappingTable[UART_CHANNEL1];
@@ -481,6 +528,8 @@ void __ISR(_UART_1_VECTOR, IPL7AUTO)UART1interrupt(void)
             union UartData rx = { 0 };
             rx._reg = uartSfr->rxreg;
             queue_add(module->rxFifo, &rx);
+            if(module->receiveHandle != NULL)
+                (*module->receiveHandle)(module);
             interrupt_clr_flag(INTERRUPT_UART1_RECEIVE_DONE);
         } else if(interrupt_get_flag(INTERRUPT_UART1_TRANSFER_DONE)) {
             union UartData tx = { 0 };
@@ -491,12 +540,16 @@ void __ISR(_UART_1_VECTOR, IPL7AUTO)UART1interrupt(void)
             interrupt_clr_flag(INTERRUPT_UART1_TRANSFER_DONE);
         }
     }
+    
+    SCHEDULER_ISR_EXIT();
 }
 #endif
 
 #if defined(_UART2) && !defined(UART_CHANNEL2_FORCE_DISABLE)
 void __ISR(_UART_2_VECTOR, IPL7AUTO)UART2interrupt(void)
 {
+    SCHEDULER_ISR_ENTER();
+    
     // Ignore NULL checks for performance
     struct UartModule* module = &uartModulePool[UART_CHANNEL2];
     const struct UartMap* uartMap = &uartMappingTable[UART_CHANNEL2];
@@ -522,6 +575,8 @@ void __ISR(_UART_2_VECTOR, IPL7AUTO)UART2interrupt(void)
             union UartData rx = { 0 };
             rx._reg = uartSfr->rxreg;
             queue_add(module->rxFifo, &rx);
+            if(module->receiveHandle != NULL)
+                (*module->receiveHandle)(module);
             interrupt_clr_flag(INTERRUPT_UART2_RECEIVE_DONE);
         } else if(interrupt_get_flag(INTERRUPT_UART2_TRANSFER_DONE)) {
             union UartData tx = { 0 };
@@ -532,12 +587,16 @@ void __ISR(_UART_2_VECTOR, IPL7AUTO)UART2interrupt(void)
             interrupt_clr_flag(INTERRUPT_UART2_TRANSFER_DONE);
         }
     }
+    
+    SCHEDULER_ISR_EXIT();
 }
 #endif
 
 #if defined(_UART3) && !defined(UART_CHANNEL3_FORCE_DISABLE)
 void __ISR(_UART_3_VECTOR, IPL7AUTO)UART3interrupt(void)
 {
+    SCHEDULER_ISR_ENTER();
+    
     // Ignore NULL checks for performance
     struct UartModule* module = &uartModulePool[UART_CHANNEL3];
     const struct UartMap* uartMap = &uartMappingTable[UART_CHANNEL3];
@@ -563,6 +622,8 @@ void __ISR(_UART_3_VECTOR, IPL7AUTO)UART3interrupt(void)
             union UartData rx = { 0 };
             rx._reg = uartSfr->rxreg;
             queue_add(module->rxFifo, &rx);
+            if(module->receiveHandle != NULL)
+                (*module->receiveHandle)(module);
             interrupt_clr_flag(INTERRUPT_UART3_RECEIVE_DONE);
         }else if(interrupt_get_flag(INTERRUPT_UART3_TRANSFER_DONE)) {
             union UartData tx = { 0 };
@@ -573,12 +634,16 @@ void __ISR(_UART_3_VECTOR, IPL7AUTO)UART3interrupt(void)
             interrupt_clr_flag(INTERRUPT_UART3_TRANSFER_DONE);
         }
     }
+    
+    SCHEDULER_ISR_EXIT();
 }
 #endif
 
 #if defined(_UART4) && !defined(UART_CHANNEL4_FORCE_DISABLE)
 void __ISR(_UART_4_VECTOR, IPL7AUTO)UART4interrupt(void)
 {
+    SCHEDULER_ISR_ENTER();
+    
     // Ignore NULL checks for performance
     struct UartModule* module = &uartModulePool[UART_CHANNEL4];
     const struct UartMap* uartMap = &uartMappingTable[UART_CHANNEL4];
@@ -604,6 +669,8 @@ void __ISR(_UART_4_VECTOR, IPL7AUTO)UART4interrupt(void)
             union UartData rx = { 0 };
             rx._reg = uartSfr->rxreg;
             queue_add(module->rxFifo, &rx);
+            if(module->receiveHandle != NULL)
+                (*module->receiveHandle)(module);
             interrupt_clr_flag(INTERRUPT_UART4_RECEIVE_DONE);
         } else if(interrupt_get_flag(INTERRUPT_UART4_TRANSFER_DONE)) {
             union UartData tx = { 0 };
@@ -614,12 +681,16 @@ void __ISR(_UART_4_VECTOR, IPL7AUTO)UART4interrupt(void)
             interrupt_clr_flag(INTERRUPT_UART4_TRANSFER_DONE);
         }
     }
+    
+    SCHEDULER_ISR_EXIT();
 }
 #endif
 
 #if defined(_UART5) && !defined(UART_CHANNEL5_FORCE_DISABLE)
 void __ISR(_UART_5_VECTOR, IPL7AUTO)UART5interrupt(void)
 {
+    SCHEDULER_ISR_ENTER();
+    
     // Ignore NULL checks for performance
     struct UartModule* module = &uartModulePool[UART_CHANNEL5];
     const struct UartMap* uartMap = &uartMappingTable[UART_CHANNEL5];
@@ -645,6 +716,8 @@ void __ISR(_UART_5_VECTOR, IPL7AUTO)UART5interrupt(void)
             union UartData rx = { 0 };
             rx._reg = uartSfr->rxreg;
             queue_add(module->rxFifo, &rx);
+            if(module->receiveHandle != NULL)
+                (*module->receiveHandle)(module);
             interrupt_clr_flag(INTERRUPT_UART5_RECEIVE_DONE);
         }else if(interrupt_get_flag(INTERRUPT_UART5_TRANSFER_DONE)) {
             union UartData tx = { 0 };
@@ -655,12 +728,16 @@ void __ISR(_UART_5_VECTOR, IPL7AUTO)UART5interrupt(void)
             interrupt_clr_flag(INTERRUPT_UART5_TRANSFER_DONE);
         }
     }
+    
+    SCHEDULER_ISR_EXIT();
 }
 #endif
 
 #if defined(_UART6) && !defined(UART_CHANNEL6_FORCE_DISABLE)
 void __ISR(_UART_6_VECTOR, IPL7AUTO)UART6interrupt(void)
 {
+    SCHEDULER_ISR_ENTER();
+    
     // Ignore NULL checks for performance
     struct UartModule* module = &uartModulePool[UART_CHANNEL6];
     const struct UartMap* uartMap = &uartMappingTable[UART_CHANNEL16];
@@ -686,6 +763,8 @@ void __ISR(_UART_6_VECTOR, IPL7AUTO)UART6interrupt(void)
             union UartData rx = { 0 };
             rx._reg = uartSfr->rxreg;
             queue_add(module->rxFifo, &rx);
+            if(module->receiveHandle != NULL)
+                (*module->receiveHandle)(module);
             interrupt_clr_flag(INTERRUPT_UART6_RECEIVE_DONE);
         }else if(interrupt_get_flag(INTERRUPT_UART6_TRANSFER_DONE)) {
             union UartData tx = { 0 };
@@ -696,5 +775,7 @@ void __ISR(_UART_6_VECTOR, IPL7AUTO)UART6interrupt(void)
             interrupt_clr_flag(INTERRUPT_UART6_TRANSFER_DONE);
         }
     }
+    
+    SCHEDULER_ISR_EXIT();
 }
 #endif
\ No newline at end of file
@@ -31,6 +31,7 @@ enum UartChannel {
 };
 
 struct UartModule;
+typedef void (*UartReceiveHandle)(struct UartModule* module);
 
 union UartData
 {
@@ -102,8 +103,8 @@ bool uart_init();
  * @param channel The channel to be used
  * @param rxBuffer An UartData array that will be used as RX FIFO queue
  * @param txBuffer An UartData array that will be uses as TX FIFO queue
- * @param rxSize The size of the RX byte array
- * @param txSize The size of the TX byte array
+ * @param rxSize The size of the RX byte array, must be a power of two
+ * @param txSize The size of the TX byte array, must be a power of two
  * @return Returns a pointer to the created UART module
  */
 struct UartModule* uart_create(const enum UartChannel channel, union UartData* rxBuffer, union UartData* txBuffer, const unsigned int rxSize, const unsigned int txSize);
@@ -114,6 +115,14 @@ struct UartModule* uart_create(const enum UartChannel channel, union UartData* r
  */
 void uart_invalidate(struct UartModule* module);
 
+/**
+ * Sets a handle that is executed each time data was received
+ * @param module The module to be changed
+ * @param handle The handle to execute, or 'NULL' to remove the current handle
+ * @note The handle is executed from within the interrupt, use 'scheduler_post' to defer the actual processing
+ */
+void uart_set_receive_handle(struct UartModule* module, const UartReceiveHandle handle);
+
 /**
  * Configures the UART module
  * @param module The module to be configured
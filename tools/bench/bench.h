@@ -0,0 +1,24 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdio.h>
+#include <time.h>
+
+/*
+ * Timing helpers shared by the host benchmarks. On x86 the time stamp counter is read, so results are in cycles,
+ * elsewhere the processor time of clock() is used and results are in nanoseconds.
+ * The firmware headers clash with POSIX names like timer_create(), so the benchmarks are built as strict C99.
+ */
+
+#if defined(__x86_64__) || defined(__i386__)
+    #include <x86intrin.h>
+    #define BENCH_UNIT              "cycles"
+    #define bench_now()             ((unsigned long long)__rdtsc())
+#else
+    #define BENCH_UNIT              "ns"
+    #define bench_now()             ((unsigned long long)clock() * (1000000000ULL / CLOCKS_PER_SEC))
+#endif
+
+#define BENCH_BARRIER()             __asm__ volatile("" ::: "memory") // Keeps the compiler from moving work out of a measurement
+
+#endif	/* BENCH_H */
@@ -0,0 +1,61 @@
+/*
+ * Cost of an add followed by a take of an unsigned short, pool queues of queue.h versus a queue of typed_queue.h
+ */
+#include "bench.h"
+#include "lib/types/queue.c"
+#include "lib/types/typed_queue.h"
+
+#define BENCH_ITERATIONS            10000000
+#define BENCH_CAPACITY              256
+
+QUEUE_DEFINE(UShortQueue, unsigned short, BENCH_CAPACITY)
+
+static unsigned short fifoBuffer[BENCH_CAPACITY];
+static unsigned short spscBuffer[BENCH_CAPACITY];
+static struct UShortQueue typedQueue = TYPED_QUEUE_INITIALIZER;
+static volatile unsigned long sum = 0;
+
+static double run_pool(struct Queue* queue)
+{
+    unsigned long long start = bench_now();
+    unsigned short in, out;
+    unsigned long i;
+    
+    for(i = 0; i < BENCH_ITERATIONS; ++i) {
+        in = (unsigned short)i;
+        queue_add(queue, &in);
+        if(queue_take(queue, &out))
+            sum += out;
+    }
+    return (double)(bench_now() - start) / BENCH_ITERATIONS;
+}
+
+static double run_typed()
+{
+    unsigned long long start = bench_now();
+    unsigned short in, out;
+    unsigned long i;
+    
+    for(i = 0; i < BENCH_ITERATIONS; ++i) {
+        in = (unsigned short)i;
+        UShortQueue_add(&typedQueue, &in);
+        if(UShortQueue_take(&typedQueue, &out))
+            sum += out;
+    }
+    return (double)(bench_now() - start) / BENCH_ITERATIONS;
+}
+
+int main()
+{
+    struct Queue* fifo;
+    struct Queue* spsc;
+    
+    queue_init();
+    fifo = queue_create(fifoBuffer, BENCH_CAPACITY, QUEUE_FIFO, QUEUE_USHORT);
+    spsc = queue_create(spscBuffer, BENCH_CAPACITY, QUEUE_SPSC, QUEUE_USHORT);
+    
+    printf("Queue add and take in %s, mean of %d iterations\n", BENCH_UNIT, BENCH_ITERATIONS);
+    printf("Pool FIFO\tPool SPSC\tQUEUE_DEFINE\n");
+    printf("%.1f\t\t%.1f\t\t%.1f\n", run_pool(fifo), run_pool(spsc), run_typed());
+    return 0;
+}
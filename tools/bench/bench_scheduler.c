@@ -0,0 +1,141 @@
+/*
+ * Pass cost of scheduler_execute() versus the linear event scan it replaced, at 5, 50 and 500 events.
+ *
+ * Events get distinct intervals from 100 ms up to 599 ms and the timebase advances 50 us per pass, so most passes find
+ * nothing due while some release an event. The idle columns repeat passes without any time passing.
+ */
+#include "bench.h"
+#include "kernel/scheduler/cfg/scheduler_config.h"
+#undef EVENT_POOL_SIZE
+#define EVENT_POOL_SIZE             500 // The include guard keeps scheduler.c from restoring the configured size
+#include "kernel/scheduler/scheduler.c"
+
+#define BENCH_PASSES                500000
+#define BENCH_TICKS_PER_PASS        250     // 50 us at the 5 MHz system tick
+#define BENCH_INTERVAL_MS           100
+#define BENCH_INTERVAL_STEP_MS      1
+
+/*
+ * The scan scheduler_execute() used before the heap, every pass walks all events and decrements their tick count
+ */
+struct LinearEvent
+{
+    SchedulerHandle handle;
+    unsigned long interval;
+    unsigned long ticks;
+};
+
+static struct LinearEvent linearPool[EVENT_POOL_SIZE];
+static size_t nLinearEvents = 0;
+static unsigned long linearLastTickCount = 0;
+static unsigned long linearTimer = 0;
+static volatile unsigned long dispatched = 0;
+
+static void bench_handle()
+{
+    dispatched++;
+}
+
+static void linear_execute()
+{
+    SchedulerHandle handle = NULL;
+    const unsigned long elapsedTicks = linearTimer - linearLastTickCount;
+    size_t i;
+    
+    linearLastTickCount += elapsedTicks;
+    for(i = 0; i < nLinearEvents; ++i) {
+        struct LinearEvent* event = &linearPool[i];
+        if(event->ticks <= elapsedTicks) {
+            if(handle == NULL) {
+                event->ticks = event->interval;
+                handle = event->handle;
+            } else
+                event->ticks = 0;
+        } else
+            event->ticks -= elapsedTicks;
+    }
+    
+    if(handle != NULL)
+        (*handle)();
+}
+
+static void linear_setup(const size_t count)
+{
+    size_t i;
+    
+    nLinearEvents = count;
+    linearLastTickCount = 0;
+    linearTimer = 0;
+    for(i = 0; i < count; ++i) {
+        linearPool[i].handle = bench_handle;
+        linearPool[i].interval = scheduler_calc_ticks(BENCH_INTERVAL_MS + i * BENCH_INTERVAL_STEP_MS, SCHEDULER_UNIT_MS);
+        linearPool[i].ticks = 0;
+    }
+}
+
+static void heap_setup(const size_t count)
+{
+    size_t i;
+    
+    HW_TIMER = 0;
+    scheduler_init();
+    for(i = 0; i < count; ++i)
+        scheduler_create_event(bench_handle, BENCH_INTERVAL_MS + i * BENCH_INTERVAL_STEP_MS, SCHEDULER_UNIT_MS, PRIO_NORMAL);
+}
+
+static double run_linear(const size_t count, const unsigned long step)
+{
+    unsigned long long start;
+    size_t i;
+    
+    linear_setup(count);
+    for(i = 0; i < count; ++i) { // Release the initial burst outside of the measurement
+        linearTimer += BENCH_TICKS_PER_PASS;
+        linear_execute();
+    }
+    
+    start = bench_now();
+    for(i = 0; i < BENCH_PASSES; ++i) {
+        linearTimer += step;
+        linear_execute();
+        BENCH_BARRIER();
+    }
+    return (double)(bench_now() - start) / BENCH_PASSES;
+}
+
+static double run_heap(const size_t count, const unsigned long step)
+{
+    unsigned long long start;
+    size_t i;
+    
+    heap_setup(count);
+    for(i = 0; i < count; ++i) {
+        HW_TIMER += BENCH_TICKS_PER_PASS;
+        scheduler_execute();
+    }
+    
+    start = bench_now();
+    for(i = 0; i < BENCH_PASSES; ++i) {
+        HW_TIMER += step;
+        scheduler_execute();
+        BENCH_BARRIER();
+    }
+    return (double)(bench_now() - start) / BENCH_PASSES;
+}
+
+int main()
+{
+    static const size_t counts[] = { 5, 50, 500 };
+    size_t i;
+    
+    printf("Scheduler pass cost in %s, mean of %d passes\n", BENCH_UNIT, BENCH_PASSES);
+    printf("Events\tLinear\tHeap\tLinear idle\tHeap idle\n");
+    for(i = 0; i < sizeof(counts) / sizeof(counts[0]); ++i) {
+        const double linear = run_linear(counts[i], BENCH_TICKS_PER_PASS);
+        const double heap = run_heap(counts[i], BENCH_TICKS_PER_PASS);
+        const double linearIdle = run_linear(counts[i], 0);
+        const double heapIdle = run_heap(counts[i], 0);
+        printf("%u\t%.1f\t%.1f\t%.1f\t\t%.1f\n", (unsigned int)counts[i], linear, heap, linearIdle, heapIdle);
+    }
+    return 0;
+}
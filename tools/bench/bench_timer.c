@@ -0,0 +1,150 @@
+/*
+ * Per tick cost of timer_execute() versus the pool scan the timing wheel replaced, against the number of active timers.
+ *
+ * The pool holds 500 timers, the active ones are soft timers with intervals spread from 1 s up to 60 s, so most ticks
+ * expire nothing while the wheel keeps cascading. Time is supplied by stand-ins of the scheduler's timebase functions.
+ */
+#include "bench.h"
+#include "kernel/utils/timer/timer.h"
+#undef TIMER_POOL_SIZE
+#define TIMER_POOL_SIZE             500 // The include guard keeps timer.c from restoring the configured size
+#include "kernel/utils/timer/timer.c"
+
+#define BENCH_TICKS                 200000  // 100 s of timer ticks
+#define BENCH_INTERVAL_MIN_MS       1000
+#define BENCH_INTERVAL_SPREAD_MS    59000
+#define BENCH_SEED                  12345
+
+/*
+ * The scan timer_execute() used before the wheel, every tick walks the whole pool and decrements the running timers
+ */
+struct PoolTimer
+{
+    unsigned long interval;
+    unsigned long ticks;
+    TimerHandle handle;
+    struct {
+        unsigned char assigned  :1;
+        unsigned char suspended :1;
+        unsigned char timedout  :1;
+    } opt;
+};
+
+static struct PoolTimer poolTimers[TIMER_POOL_SIZE];
+static SchedulerTicks benchTicks = 0; // One system tick per microsecond
+static unsigned long benchRandom = BENCH_SEED;
+static volatile unsigned long expired = 0;
+
+SchedulerTicks scheduler_get_ticks()
+{
+    return benchTicks;
+}
+
+SchedulerTicks scheduler_calc_ticks(const unsigned long time, const enum SchedulerIntervalUnit unit)
+{
+    switch(unit) {
+        default:
+        case SCHEDULER_UNIT_US: return time;
+        case SCHEDULER_UNIT_MS: return time * 1000ULL;
+        case SCHEDULER_UNIT_S:  return time * 1000000ULL;
+    }
+}
+
+SchedulerId scheduler_create_event(const SchedulerHandle handle, const unsigned long interval, const enum SchedulerIntervalUnit unit, const unsigned char priority)
+{
+    return 1;
+}
+
+static unsigned long bench_interval_ms()
+{
+    benchRandom = benchRandom * 1103515245UL + 12345UL;
+    return BENCH_INTERVAL_MIN_MS + (benchRandom >> 8) % BENCH_INTERVAL_SPREAD_MS;
+}
+
+static void bench_handle(struct Timer* timer, void* context)
+{
+    expired++;
+}
+
+static void pool_execute()
+{
+    TimerHandle handle = NULL;
+    size_t i;
+    
+    for(i = 0; i < TIMER_POOL_SIZE; ++i) {
+        struct PoolTimer* timer = &poolTimers[i];
+        if(timer->opt.assigned && !timer->opt.suspended) {
+            if(timer->ticks > 0)
+                timer->opt.timedout = !(--timer->ticks);
+            else
+                timer->opt.timedout = 1;
+            
+            if(timer->opt.timedout && handle == NULL) {
+                timer->ticks = timer->interval;
+                timer->opt.timedout = 0;
+                handle = timer->handle;
+            }
+        }
+    }
+    
+    if(handle != NULL)
+        (*handle)(NULL, NULL);
+}
+
+static double run_pool(const size_t count)
+{
+    unsigned long long start;
+    size_t i;
+    
+    benchRandom = BENCH_SEED;
+    for(i = 0; i < TIMER_POOL_SIZE; ++i) {
+        poolTimers[i].opt.assigned = 1; // The whole pool is assigned, only the running timers count down
+        poolTimers[i].opt.suspended = (i >= count);
+        poolTimers[i].opt.timedout = 0;
+        poolTimers[i].handle = bench_handle;
+        poolTimers[i].interval = (bench_interval_ms() * 1000UL) / TIMER_TICK_INTERVAL;
+        poolTimers[i].ticks = poolTimers[i].interval;
+    }
+    
+    start = bench_now();
+    for(i = 0; i < BENCH_TICKS; ++i) {
+        pool_execute();
+        BENCH_BARRIER();
+    }
+    return (double)(bench_now() - start) / BENCH_TICKS;
+}
+
+static double run_wheel(const size_t count)
+{
+    unsigned long long start;
+    size_t i;
+    
+    benchTicks = 0;
+    benchRandom = BENCH_SEED;
+    timer_init();
+    for(i = 0; i < count; ++i)
+        timer_start(timer_create(TIMER_SOFT, bench_handle, NULL), bench_interval_ms(), TIMER_UNIT_MS);
+    
+    start = bench_now();
+    for(i = 0; i < BENCH_TICKS; ++i) {
+        benchTicks += TIMER_TICK_INTERVAL;
+        timer_execute();
+        BENCH_BARRIER();
+    }
+    return (double)(bench_now() - start) / BENCH_TICKS;
+}
+
+int main()
+{
+    static const size_t counts[] = { 0, 10, 100, 500 };
+    size_t i;
+    
+    printf("Timer tick cost in %s, mean of %d ticks, pool of %d timers\n", BENCH_UNIT, BENCH_TICKS, TIMER_POOL_SIZE);
+    printf("Active\tPool scan\tWheel\n");
+    for(i = 0; i < sizeof(counts) / sizeof(counts[0]); ++i) {
+        const double pool = run_pool(counts[i]);
+        const double wheel = run_wheel(counts[i]);
+        printf("%u\t%.1f\t\t%.1f\n", (unsigned int)counts[i], pool, wheel);
+    }
+    return 0;
+}
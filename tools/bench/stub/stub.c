@@ -0,0 +1,24 @@
+#include <xc.h>
+
+/*
+ * Special function registers and coprocessor 0 of the host stand-in, see xc.h
+ */
+
+#define STUB_REGISTER(name)         volatile unsigned int name = 0;
+STUB_REGISTER(TMR4)
+STUB_REGISTER(PR4)
+STUB_REGISTER(T4CON)
+#undef STUB_REGISTER
+
+static unsigned int coreCount = 0;
+static unsigned int coreStatus = 0; // Interrupt priority level 0, the main loop
+
+unsigned int _CP0_GET_COUNT(void)
+{
+    return coreCount;
+}
+
+unsigned int _CP0_GET_STATUS(void)
+{
+    return coreStatus;
+}
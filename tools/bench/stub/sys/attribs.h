@@ -0,0 +1,7 @@
+#ifndef STUB_ATTRIBS_H
+#define STUB_ATTRIBS_H
+
+// Interrupt service routines are plain functions on the host, the benchmarks call them directly when needed
+#define __ISR(vector, ipl)          __attribute__((used))
+
+#endif	/* STUB_ATTRIBS_H */
@@ -0,0 +1,21 @@
+#ifndef STUB_XC_H
+#define STUB_XC_H
+
+/*
+ * Minimal stand-in for the XC32 device header, so firmware modules can be compiled into host benchmarks.
+ * Special function registers are plain variables defined in stub.c, a benchmark drives timers by writing them.
+ */
+
+#define _SYS_CLK                    80000000UL
+#define _PB_DIV                     1
+
+#define STUB_REGISTER(name)         extern volatile unsigned int name;
+STUB_REGISTER(TMR4)
+STUB_REGISTER(PR4)
+STUB_REGISTER(T4CON)
+#undef STUB_REGISTER
+
+unsigned int _CP0_GET_COUNT(void);
+unsigned int _CP0_GET_STATUS(void);
+
+#endif	/* STUB_XC_H */